@@ -102,8 +102,8 @@
 
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
 
-extern int yyleng;
-extern FILE *yyin, *yyout;
+extern thread_local int yyleng;
+extern thread_local FILE *yyin, *yyout;
 
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
@@ -202,7 +202,7 @@ struct yy_buffer_state
 #define YY_BUFFER_EOF_PENDING 2
 	};
 
-static YY_BUFFER_STATE yy_current_buffer = 0;
+static thread_local YY_BUFFER_STATE yy_current_buffer = 0;
 
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
@@ -212,22 +212,22 @@ static YY_BUFFER_STATE yy_current_buffer = 0;
 
 
 /* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
+static thread_local char yy_hold_char;
 
-static int yy_n_chars;		/* number of characters read into yy_ch_buf */
+static thread_local int yy_n_chars;		/* number of characters read into yy_ch_buf */
 
 
-int yyleng;
+thread_local int yyleng;
 
 /* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 1;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
+static thread_local char *yy_c_buf_p = (char *) 0;
+static thread_local int yy_init = 1;		/* whether we need to initialize */
+static thread_local int yy_start = 0;	/* start state number */
 
 /* Flag which is used to allow yywrap()'s to do buffer switches
  * instead of setting up a fresh yyin.  A bit of a hack ...
  */
-static int yy_did_buffer_switch_on_eof;
+static thread_local int yy_did_buffer_switch_on_eof;
 
 void yyrestart YY_PROTO(( FILE *input_file ));
 
@@ -268,11 +268,11 @@ static void yy_flex_free YY_PROTO(( void * ));
 
 #define FLEX_DEBUG
 typedef unsigned char YY_CHAR;
-FILE *yyin = (FILE *) 0, *yyout = (FILE *) 0;
+thread_local FILE *yyin = (FILE *) 0, *yyout = (FILE *) 0;
 typedef int yy_state_type;
 
 #define FLEX_DEBUG
-extern char *yytext;
+extern thread_local char *yytext;
 #define yytext_ptr yytext
 
 static yy_state_type yy_get_previous_state YY_PROTO(( void ));
@@ -503,8 +503,8 @@ static yyconst short int yy_chk[383] =
       186,  186
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
+static thread_local yy_state_type yy_last_accepting_state;
+static thread_local char *yy_last_accepting_cpos;
 
 extern int yy_flex_debug;
 int yy_flex_debug = 1;
@@ -527,7 +527,7 @@ static yyconst short int yy_rule_linenum[64] =
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *yytext;
+thread_local char *yytext;
 #line 1 "cool.flex"
 #define INITIAL 0
 /*
@@ -539,6 +539,8 @@ char *yytext;
  * to the code in the file.  Dont remove anything that was here initially
  */
 #line 11 "cool.flex"
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <cool-parse.h>
 #include <stringtab.h>
 #include <utilities.h>
@@ -547,11 +549,16 @@ char *yytext;
 #define yylval cool_yylval
 #define yylex  cool_yylex
 
+/* All the scanner's state is per thread, so that coolc can scan several
+ * files at once: the variables here are thread_local, and the Makefile
+ * makes those of the generated scanner thread_local as well.
+ */
+
 /* Max size of string constants */
 #define MAX_STR_CONST 1025
 #define YY_NO_UNPUT   /* keep g++ happy */
 
-extern FILE *fin; /* we read from this file */
+extern thread_local FILE *fin; /* we read from this file */
 
 /* define YY_INPUT so we read from the FILE fin:
  * This change makes it possible to use this scanner in
@@ -562,15 +569,26 @@ extern FILE *fin; /* we read from this file */
 	if ( (result = fread( (char*)buf, sizeof(char), max_size, fin)) < 0) \
 		YY_FATAL_ERROR( "read() in flex scanner failed");
 
-char string_buf[MAX_STR_CONST]; /* to assemble string constants */
-char *string_buf_ptr;
+thread_local char string_buf[MAX_STR_CONST]; /* to assemble string constants */
+thread_local char *string_buf_ptr;
 
-extern int curr_lineno;
+/* When the input is scanned in place (see cool_scan_file), a string
+ * constant without escapes is interned straight from the input:
+ * string_start points at its first character.  The first escape copies
+ * what has been seen so far into string_buf and clears string_start.
+ */
+static thread_local int scanning_in_place = 0;
+static thread_local char *string_start;
+#define STRING_LENGTH \
+  (string_start ? yytext - string_start : string_buf_ptr - string_buf)
+static void stage_string();
+
+extern thread_local int curr_lineno;
 extern int verbose_flag;
 
-extern YYSTYPE cool_yylval;
+extern thread_local YYSTYPE cool_yylval;
 
-size_t comment_depth = 0;
+thread_local size_t comment_depth = 0;
 
 
 /*
@@ -625,9 +643,9 @@ static int input YY_PROTO(( void ));
 #endif
 
 #if YY_STACK_USED
-static int yy_start_stack_ptr = 0;
-static int yy_start_stack_depth = 0;
-static int *yy_start_stack = 0;
+static thread_local int yy_start_stack_ptr = 0;
+static thread_local int yy_start_stack_depth = 0;
+static thread_local int *yy_start_stack = 0;
 #ifndef YY_NO_PUSH_STATE
 static void yy_push_state YY_PROTO(( int new_state ));
 #endif
@@ -752,7 +770,7 @@ YY_DECL
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
 
-#line 98 "cool.flex"
+#line 116 "cool.flex"
 
 
  /*
@@ -864,17 +882,23 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 109 "cool.flex"
+#line 127 "cool.flex"
 {
   string_buf_ptr = string_buf;
+  string_start = scanning_in_place ? yytext + 1 : NULL;
   BEGIN(STR);
 }
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 113 "cool.flex"
+#line 132 "cool.flex"
 {
   BEGIN(INITIAL);
+  if (string_start) {
+    cool_yylval.symbol =
+      stringtable.add_string(string_start, yytext - string_start);
+    return STR_CONST;
+  }
   (*string_buf_ptr) = '\0';
   cool_yylval.symbol = stringtable.add_string(string_buf);
   return STR_CONST;
@@ -882,20 +906,21 @@ YY_RULE_SETUP
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 120 "cool.flex"
+#line 144 "cool.flex"
 {
   ++curr_lineno;
-  if (string_buf_ptr - string_buf + 2 > MAX_STR_CONST) {
+  if (STRING_LENGTH + 2 > MAX_STR_CONST) {
     BEGIN(STRERROR);
     cool_yylval.error_msg = "String constant too long";
     return (ERROR);
   }
+  stage_string();
   *(string_buf_ptr++) = '\n';
 }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 129 "cool.flex"
+#line 154 "cool.flex"
 {
   ++curr_lineno;
   cool_yylval.error_msg = "Unterminated string constant";
@@ -906,7 +931,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 137 "cool.flex"
+#line 162 "cool.flex"
 {
   cool_yylval.error_msg = "String contains null character";
   BEGIN(STRERROR);
@@ -914,7 +939,7 @@ YY_RULE_SETUP
 }
 	YY_BREAK
 case YY_STATE_EOF(STR):
-#line 142 "cool.flex"
+#line 167 "cool.flex"
 {
   cool_yylval.error_msg = "EOF in string constant";
   BEGIN(STRERROR);
@@ -923,13 +948,14 @@ case YY_STATE_EOF(STR):
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 149 "cool.flex"
+#line 174 "cool.flex"
 {
-  if (string_buf_ptr - string_buf + 2 > MAX_STR_CONST) {
+  if (STRING_LENGTH + 2 > MAX_STR_CONST) {
     BEGIN(STRERROR);
     cool_yylval.error_msg = "String constant too long";
     return (ERROR);
   }
+  stage_string();
   if (yytext[1] == 'b') {
     (*string_buf_ptr++) = '\b';
   } else if (yytext[1] == 't') {
@@ -949,48 +975,49 @@ YY_RULE_SETUP
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 172 "cool.flex"
+#line 198 "cool.flex"
 {
-  if (string_buf_ptr - string_buf + 2 > MAX_STR_CONST) {
+  if (STRING_LENGTH + 2 > MAX_STR_CONST) {
     BEGIN(STRERROR);
     cool_yylval.error_msg = "String constant too long";
     return (ERROR);
   }
-  *(string_buf_ptr++) = yytext[0];
+  if (!string_start)
+    *(string_buf_ptr++) = yytext[0];
 }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 182 "cool.flex"
+#line 209 "cool.flex"
 {
   BEGIN(INITIAL);
 }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 185 "cool.flex"
+#line 212 "cool.flex"
 {
   BEGIN(INITIAL);
 }
 	YY_BREAK
 case YY_STATE_EOF(STRERROR):
-#line 188 "cool.flex"
+#line 215 "cool.flex"
 { return 0; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 189 "cool.flex"
+#line 216 "cool.flex"
 {}
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 191 "cool.flex"
+#line 218 "cool.flex"
 {
   BEGIN(LINECMT);
 }
 	YY_BREAK
 case YY_STATE_EOF(LINECMT):
-#line 195 "cool.flex"
+#line 222 "cool.flex"
 {
   BEGIN(INITIAL);
   return 0;
@@ -998,7 +1025,7 @@ case YY_STATE_EOF(LINECMT):
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 200 "cool.flex"
+#line 227 "cool.flex"
 {
   BEGIN(INITIAL);
   ++curr_lineno;
@@ -1006,12 +1033,12 @@ YY_RULE_SETUP
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 204 "cool.flex"
+#line 231 "cool.flex"
 {}
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 206 "cool.flex"
+#line 233 "cool.flex"
 {
   ++comment_depth;
   BEGIN(CMT);
@@ -1019,13 +1046,13 @@ YY_RULE_SETUP
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 211 "cool.flex"
+#line 238 "cool.flex"
 {
   ++comment_depth;
 }
 	YY_BREAK
 case YY_STATE_EOF(CMT):
-#line 215 "cool.flex"
+#line 242 "cool.flex"
 {
   BEGIN(INITIAL);
   cool_yylval.error_msg = "EOF in comment";
@@ -1034,19 +1061,19 @@ case YY_STATE_EOF(CMT):
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 220 "cool.flex"
+#line 247 "cool.flex"
 {
   ++curr_lineno;
 }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 223 "cool.flex"
+#line 250 "cool.flex"
 {}
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 225 "cool.flex"
+#line 252 "cool.flex"
 {
   if (--comment_depth == 0) {
     BEGIN(INITIAL);
@@ -1055,7 +1082,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 231 "cool.flex"
+#line 258 "cool.flex"
 {
   cool_yylval.error_msg = "Unmatched *)";
   return (ERROR);
@@ -1063,222 +1090,222 @@ YY_RULE_SETUP
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 237 "cool.flex"
+#line 264 "cool.flex"
 { return (CLASS); }
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 238 "cool.flex"
+#line 265 "cool.flex"
 { return (ELSE); }
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 239 "cool.flex"
+#line 266 "cool.flex"
 { cool_yylval.boolean = false; return (BOOL_CONST); }
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 240 "cool.flex"
+#line 267 "cool.flex"
 { return (FI); }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 241 "cool.flex"
+#line 268 "cool.flex"
 { return (IF); }
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 242 "cool.flex"
+#line 269 "cool.flex"
 { return (IN); }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 243 "cool.flex"
+#line 270 "cool.flex"
 { return (INHERITS); }
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 244 "cool.flex"
+#line 271 "cool.flex"
 { return (ISVOID); }
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 245 "cool.flex"
+#line 272 "cool.flex"
 { return (LET); }
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 246 "cool.flex"
+#line 273 "cool.flex"
 { return (LOOP); }
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 247 "cool.flex"
+#line 274 "cool.flex"
 { return (POOL); }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 248 "cool.flex"
+#line 275 "cool.flex"
 { return (THEN); }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 249 "cool.flex"
+#line 276 "cool.flex"
 { return (WHILE); }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 250 "cool.flex"
+#line 277 "cool.flex"
 { return (ASSIGN); }
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 251 "cool.flex"
+#line 278 "cool.flex"
 { return (CASE); }
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 252 "cool.flex"
+#line 279 "cool.flex"
 { return (ESAC); }
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 253 "cool.flex"
+#line 280 "cool.flex"
 { return (NEW); }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 254 "cool.flex"
+#line 281 "cool.flex"
 { cool_yylval.symbol = inttable.add_string(yytext); return (INT_CONST); }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 255 "cool.flex"
+#line 282 "cool.flex"
 { return (OF); }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 256 "cool.flex"
+#line 283 "cool.flex"
 { return (DARROW); }
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 257 "cool.flex"
+#line 284 "cool.flex"
 { return (NOT); }
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 258 "cool.flex"
+#line 285 "cool.flex"
 { cool_yylval.boolean = true; return (BOOL_CONST); }
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 259 "cool.flex"
-{ cool_yylval.symbol = stringtable.add_string(yytext); return (TYPEID); }
+#line 286 "cool.flex"
+{ cool_yylval.symbol = idtable.add_string(yytext); return (TYPEID); }
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 260 "cool.flex"
-{ cool_yylval.symbol = stringtable.add_string(yytext); return (OBJECTID); }
+#line 287 "cool.flex"
+{ cool_yylval.symbol = idtable.add_string(yytext); return (OBJECTID); }
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 261 "cool.flex"
+#line 288 "cool.flex"
 { ++curr_lineno; }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 262 "cool.flex"
+#line 289 "cool.flex"
 { }
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 263 "cool.flex"
+#line 290 "cool.flex"
 { return (LE); }
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 264 "cool.flex"
+#line 291 "cool.flex"
 { return '+'; }
 	YY_BREAK
 case 48:
 YY_RULE_SETUP
-#line 265 "cool.flex"
+#line 292 "cool.flex"
 { return '/'; }
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 266 "cool.flex"
+#line 293 "cool.flex"
 { return '-'; }
 	YY_BREAK
 case 50:
 YY_RULE_SETUP
-#line 267 "cool.flex"
+#line 294 "cool.flex"
 { return '*'; }
 	YY_BREAK
 case 51:
 YY_RULE_SETUP
-#line 268 "cool.flex"
+#line 295 "cool.flex"
 { return '='; }
 	YY_BREAK
 case 52:
 YY_RULE_SETUP
-#line 269 "cool.flex"
+#line 296 "cool.flex"
 { return '<'; }
 	YY_BREAK
 case 53:
 YY_RULE_SETUP
-#line 270 "cool.flex"
+#line 297 "cool.flex"
 { return '.'; }
 	YY_BREAK
 case 54:
 YY_RULE_SETUP
-#line 271 "cool.flex"
+#line 298 "cool.flex"
 { return '~'; }
 	YY_BREAK
 case 55:
 YY_RULE_SETUP
-#line 272 "cool.flex"
+#line 299 "cool.flex"
 { return ','; }
 	YY_BREAK
 case 56:
 YY_RULE_SETUP
-#line 273 "cool.flex"
+#line 300 "cool.flex"
 { return ';'; }
 	YY_BREAK
 case 57:
 YY_RULE_SETUP
-#line 274 "cool.flex"
+#line 301 "cool.flex"
 { return ':'; }
 	YY_BREAK
 case 58:
 YY_RULE_SETUP
-#line 275 "cool.flex"
+#line 302 "cool.flex"
 { return '('; }
 	YY_BREAK
 case 59:
 YY_RULE_SETUP
-#line 276 "cool.flex"
+#line 303 "cool.flex"
 { return ')'; }
 	YY_BREAK
 case 60:
 YY_RULE_SETUP
-#line 277 "cool.flex"
+#line 304 "cool.flex"
 { return '@'; }
 	YY_BREAK
 case 61:
 YY_RULE_SETUP
-#line 278 "cool.flex"
+#line 305 "cool.flex"
 { return '{'; }
 	YY_BREAK
 case 62:
 YY_RULE_SETUP
-#line 279 "cool.flex"
+#line 306 "cool.flex"
 { return '}'; }
 	YY_BREAK
 case 63:
 YY_RULE_SETUP
-#line 280 "cool.flex"
+#line 307 "cool.flex"
 { cool_yylval.error_msg = yytext; return (ERROR); }
 	YY_BREAK
 /*
@@ -1293,7 +1320,7 @@ YY_RULE_SETUP
   */
 case 64:
 YY_RULE_SETUP
-#line 297 "cool.flex"
+#line 324 "cool.flex"
 ECHO;
 	YY_BREAK
 #line 1300 "cool-lex.cc"
@@ -2187,5 +2214,81 @@ int main()
 	return 0;
 	}
 #endif
-#line 297 "cool.flex"
+#line 325 "cool.flex"
 
+/*
+ * Copy the part of the current string constant seen so far (everything
+ * before yytext) from the input into string_buf.
+ */
+static void stage_string()
+{
+  if (string_start) {
+    string_buf_ptr = string_buf;
+    while (string_start < yytext)
+      *(string_buf_ptr++) = *(string_start++);
+    string_start = NULL;
+  }
+}
+
+/*
+ * cool_scan_file makes the scanner read the file open as f.  A regular
+ * file is mapped into memory and scanned in place with yy_scan_buffer,
+ * so the text is never copied into a flex buffer.  Flex writes into the
+ * buffer it scans and wants it to end in two NULs, so the mapping is
+ * private and placed at the start of an anonymous (zeroed) region two
+ * bytes longer than the file.  Anything that cannot be mapped is read
+ * through YY_INPUT from fin as before.
+ */
+static thread_local char *mapped_text = NULL;
+static thread_local size_t mapped_size;
+static thread_local YY_BUFFER_STATE mapped_buffer;
+
+void cool_unmap_file()
+{
+  if (scanning_in_place)
+    yy_delete_buffer(mapped_buffer);
+  if (mapped_text) {
+    munmap(mapped_text, mapped_size);
+    mapped_text = NULL;
+  }
+  scanning_in_place = 0;
+}
+
+void cool_scan_file(FILE *f)
+{
+  struct stat st;
+
+  cool_unmap_file();
+  if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+    size_t len = st.st_size;
+    mapped_size = len + 2;
+    mapped_text = (char *) mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped_text == MAP_FAILED)
+      mapped_text = NULL;
+    else if (len > 0 &&
+	     mmap(mapped_text, len, PROT_READ | PROT_WRITE,
+		  MAP_PRIVATE | MAP_FIXED, fileno(f), 0) == MAP_FAILED) {
+      munmap(mapped_text, mapped_size);
+      mapped_text = NULL;
+    }
+  }
+  if (mapped_text) {
+    mapped_buffer = yy_scan_buffer(mapped_text, mapped_size);
+    scanning_in_place = 1;
+  } else
+    yyrestart(f);
+}
+
+/*
+ * cool_scan_string makes the scanner read the len characters at text,
+ * which it copies into a buffer of its own and scans in place; the copy
+ * is freed by cool_unmap_file.  This is how the compiler library reads
+ * programs held in memory.
+ */
+void cool_scan_string(const char *text, int len)
+{
+  cool_unmap_file();
+  mapped_buffer = yy_scan_bytes(text, len);
+  scanning_in_place = 1;
+}
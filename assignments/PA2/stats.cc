@@ -0,0 +1,224 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////
+//
+//  stats.cc
+//
+//  Phase timings and counters for option -P; see stats.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "cool-io.h"
+#include "stringtab.h"
+#include "stats.h"
+
+int stats_format;                       // set by -P in handle_flags
+thread_local StatCounters stat_counters;
+
+static StatCounters totals;             // what the threads have merged
+static std::mutex totals_lock;
+
+struct PhaseStats {
+  const char *name;
+  double wall;                          // seconds
+  double cpu;                           // seconds, all threads
+  long peak_rss;                        // kilobytes, at the end
+};
+
+struct MethodStats {
+  std::string class_name;
+  std::string method_name;
+  long instructions;
+};
+
+//
+// The phases and methods are those the thread bracketed, so that
+// compilations on different threads keep their records apart.  They are
+// made on the thread's first record and never freed: exit() destroys
+// the thread_local objects of the main thread before print_stats runs
+// from atexit.
+//
+struct ThreadRecords {
+  std::vector<PhaseStats> phases;
+  std::vector<MethodStats> methods;
+};
+static thread_local ThreadRecords *records;
+
+static ThreadRecords& thread_records()
+{
+  if (records == NULL)
+    records = new ThreadRecords;
+  return *records;
+}
+
+static thread_local const char *current_phase;  // NULL between phases
+static thread_local std::chrono::steady_clock::time_point phase_wall_start;
+static thread_local double phase_cpu_start;
+static thread_local long method_start;  // instructions before the method
+
+static double cpu_seconds(const struct rusage& u)
+{
+  return u.ru_utime.tv_sec + u.ru_utime.tv_usec / 1e6 +
+         u.ru_stime.tv_sec + u.ru_stime.tv_usec / 1e6;
+}
+
+void merge_counters()
+{
+  std::lock_guard<std::mutex> guard(totals_lock);
+  totals.tokens += stat_counters.tokens;
+  totals.tree_nodes += stat_counters.tree_nodes;
+  totals.symtab_lookups += stat_counters.symtab_lookups;
+  totals.semant_errors += stat_counters.semant_errors;
+  totals.semant_cached += stat_counters.semant_cached;
+  totals.instructions += stat_counters.instructions;
+  stat_counters = StatCounters();
+}
+
+void begin_phase(const char *name)
+{
+  if (current_phase != NULL)
+    end_phase();
+  struct rusage u;
+  getrusage(RUSAGE_SELF, &u);
+  current_phase = name;
+  phase_cpu_start = cpu_seconds(u);
+  phase_wall_start = std::chrono::steady_clock::now();
+}
+
+void end_phase()
+{
+  std::chrono::duration<double> wall =
+    std::chrono::steady_clock::now() - phase_wall_start;
+  struct rusage u;
+  getrusage(RUSAGE_SELF, &u);
+  PhaseStats p = { current_phase, wall.count(),
+                   cpu_seconds(u) - phase_cpu_start, u.ru_maxrss };
+  thread_records().phases.push_back(p);
+  current_phase = NULL;
+}
+
+//
+// Methods are only recorded for the report, so that a long-lived process
+// compiling without -P does not keep them.
+//
+void begin_method(char *class_name, char *method_name)
+{
+  if (stats_format == STATS_NONE)
+    return;
+  MethodStats m = { class_name, method_name, 0 };
+  thread_records().methods.push_back(m);
+  method_start = stat_counters.instructions;
+}
+
+void end_method()
+{
+  if (stats_format == STATS_NONE)
+    return;
+  thread_records().methods.back().instructions =
+    stat_counters.instructions - method_start;
+}
+
+//
+// The reports.  Identifiers and phase names need no escaping in JSON.
+//
+template <class Elem>
+static void print_table_text(ostream& s, const char *name,
+                             StringTable<Elem>& t)
+{
+  s << name << ": " << t.num_entries() << " entries, "
+    << t.num_buckets() << " buckets, " << t.num_searches() << " searches, "
+    << t.num_probes() << " probes\n";
+}
+
+template <class Elem>
+static void print_table_json(ostream& s, const char *name,
+                             StringTable<Elem>& t)
+{
+  s << "\"" << name << "\": {\"entries\": " << t.num_entries()
+    << ", \"buckets\": " << t.num_buckets()
+    << ", \"searches\": " << t.num_searches()
+    << ", \"probes\": " << t.num_probes() << "}";
+}
+
+static void print_text(ostream& s)
+{
+  std::vector<PhaseStats>& phases = thread_records().phases;
+  std::vector<MethodStats>& methods = thread_records().methods;
+  s << std::left << std::setw(12) << "phase" << std::right
+    << std::setw(10) << "wall (s)" << std::setw(10) << "cpu (s)"
+    << std::setw(16) << "peak RSS (KB)" << "\n";
+  s << std::fixed << std::setprecision(4);
+  for (size_t i = 0; i < phases.size(); i++)
+    s << std::left << std::setw(12) << phases[i].name << std::right
+      << std::setw(10) << phases[i].wall << std::setw(10) << phases[i].cpu
+      << std::setw(16) << phases[i].peak_rss << "\n";
+
+  s << "tokens: " << totals.tokens << "\n"
+    << "tree nodes: " << totals.tree_nodes << "\n"
+    << "symbol table lookups: " << totals.symtab_lookups << "\n"
+    << "semantic errors: " << totals.semant_errors << "\n"
+    << "classes from semant cache: " << totals.semant_cached << "\n"
+    << "instructions: " << totals.instructions << "\n";
+  print_table_text(s, "idtable", idtable);
+  print_table_text(s, "inttable", inttable);
+  print_table_text(s, "stringtable", stringtable);
+  for (size_t i = 0; i < methods.size(); i++)
+    s << methods[i].class_name << "." << methods[i].method_name << ": "
+      << methods[i].instructions << " instructions\n";
+}
+
+static void print_json(ostream& s)
+{
+  std::vector<PhaseStats>& phases = thread_records().phases;
+  std::vector<MethodStats>& methods = thread_records().methods;
+  s << "{\"phases\": [";
+  for (size_t i = 0; i < phases.size(); i++)
+    s << (i ? ", " : "") << "{\"name\": \"" << phases[i].name
+      << "\", \"wall\": " << phases[i].wall
+      << ", \"cpu\": " << phases[i].cpu
+      << ", \"peak_rss_kb\": " << phases[i].peak_rss << "}";
+  s << "],\n \"counters\": {\"tokens\": " << totals.tokens
+    << ", \"tree_nodes\": " << totals.tree_nodes
+    << ", \"symtab_lookups\": " << totals.symtab_lookups
+    << ", \"semant_errors\": " << totals.semant_errors
+    << ", \"semant_cached\": " << totals.semant_cached
+    << ", \"instructions\": " << totals.instructions << "},\n"
+    << " \"string_tables\": {";
+  print_table_json(s, "idtable", idtable);
+  s << ", ";
+  print_table_json(s, "inttable", inttable);
+  s << ", ";
+  print_table_json(s, "stringtable", stringtable);
+  s << "},\n \"methods\": [";
+  for (size_t i = 0; i < methods.size(); i++)
+    s << (i ? ", " : "") << "{\"class\": \"" << methods[i].class_name
+      << "\", \"method\": \"" << methods[i].method_name
+      << "\", \"instructions\": " << methods[i].instructions << "}";
+  s << "]}\n";
+}
+
+void print_stats()
+{
+  static thread_local bool printed = false;
+  if (stats_format == STATS_NONE || printed)
+    return;
+  printed = true;
+  if (current_phase != NULL)
+    end_phase();
+  merge_counters();
+  if (stats_format == STATS_JSON)
+    print_json(cerr);
+  else
+    print_text(cerr);
+}
@@ -18,10 +18,11 @@ template class StringTable<IdEntry>;
 template class StringTable<StringEntry>;
 template class StringTable<IntEntry>;
 
-Entry::Entry(char *s, int l, int i) : len(l), index(i) {
-  str = new char [len+1];
-  strncpy(str, s, len);
-  str[len] = '\0';
+//
+// The string is copied into the arena right behind the Entry itself.
+//
+Entry::Entry(char *s, int l, int i) : len(l), index(i), order(0) {
+  str = compilation_arena->copy_string(s, len);
 }
 
 int Entry::equal_string(char *string, int length) const
@@ -74,6 +75,7 @@ StringEntry::StringEntry(char *s, int l, int i) : Entry(s,l,i) { }
 IdEntry::IdEntry(char *s, int l, int i) : Entry(s,l,i) { }
 IntEntry::IntEntry(char *s, int l, int i) : Entry(s,l,i) { }
 
-IdTable idtable;
-IntTable inttable;
-StrTable stringtable;
+thread_local unsigned long intern_order;
+
+static StringTables default_tables;
+thread_local StringTables *string_tables = &default_tables;
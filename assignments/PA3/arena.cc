@@ -0,0 +1,96 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////
+//
+//  arena.cc
+//
+//  Block management for the compilation arena; see arena.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+int arena_debug;                      // set by -m in handle_flags
+
+static Arena default_arena;
+thread_local Arena *compilation_arena = &default_arena;
+
+Arena::~Arena()
+{
+  release();
+}
+
+//
+// Start a new block when the current one cannot hold n bytes.  Requests
+// larger than a quarter block get a block of their own, which is put
+// behind the current one so that the rest of the current block is not
+// wasted.
+//
+void *Arena::allocate_block(size_t n)
+{
+  size_t size = n > BLOCK_SIZE / 4 ? n : BLOCK_SIZE;
+  Block *b = (Block *) malloc(sizeof(Block) + size);
+  if (b == NULL) {
+    cerr << "Out of memory in the compilation arena\n";
+    exit(1);
+  }
+  b->size = size;
+  reserved += size;
+  num_blocks++;
+
+  char *data = (char *) (b + 1);
+  if (size != BLOCK_SIZE && blocks != NULL) {
+    b->next = blocks->next;
+    blocks->next = b;
+    return data;
+  }
+  b->next = blocks;
+  blocks = b;
+  next_free = data + n;
+  limit = data + size;
+  return data;
+}
+
+char *Arena::copy_string(const char *s, int len)
+{
+  char *str = (char *) allocate(len + 1);
+  memcpy(str, s, len);
+  str[len] = '\0';
+  return str;
+}
+
+void Arena::release()
+{
+  if (arena_debug && num_allocs > 0)
+    print_stats(cerr);
+  if (in_use > high_water)
+    high_water = in_use;
+  if (reserved > high_reserved)
+    high_reserved = reserved;
+
+  while (blocks != NULL) {
+    Block *next = blocks->next;
+    free(blocks);
+    blocks = next;
+  }
+  next_free = limit = NULL;
+  in_use = reserved = 0;
+  num_allocs = 0;
+  num_blocks = 0;
+}
+
+void Arena::print_stats(ostream& s) const
+{
+  s << "arena: " << num_allocs << " allocations, "
+    << in_use << " bytes in use, "
+    << reserved << " bytes in " << num_blocks << " blocks; "
+    << "high-water mark " << high_water_mark() << " bytes in use, "
+    << (reserved > high_reserved ? reserved : high_reserved)
+    << " reserved\n";
+}
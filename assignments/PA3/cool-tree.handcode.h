@@ -9,7 +9,7 @@
 #include "cool.h"
 #include "stringtab.h"
 #define yylineno curr_lineno;
-extern int yylineno;
+extern thread_local int yylineno;
 
 inline Boolean copy_Boolean(Boolean b) {return b; }
 inline void assert_Boolean(Boolean) {}
@@ -44,49 +44,86 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+//
+// The kind of each constructor's nodes (tree_node::get_kind), so that
+// passes can switch on a node instead of asking the type information.
+// Lists are NODE_list.
+//
+enum NodeKind {
+  NODE_list = 0,
+  NODE_program, NODE_class_, NODE_method, NODE_attr, NODE_formal,
+  NODE_branch, NODE_assign, NODE_static_dispatch, NODE_dispatch, NODE_cond,
+  NODE_loop, NODE_typcase, NODE_block, NODE_let, NODE_plus, NODE_sub,
+  NODE_mul, NODE_divide, NODE_neg, NODE_lt, NODE_eq, NODE_leq, NODE_comp,
+  NODE_int_const, NODE_bool_const, NODE_string_const, NODE_new_,
+  NODE_isvoid, NODE_no_expr, NODE_object,
+  NODE_KINDS
+};
+
+//
+// n as a T (a constructor's class, e.g. attr_class) if it is one,
+// otherwise NULL.
+//
+template <class T> inline T *node_cast(tree_node *n)
+  { return n != NULL && n->get_kind() == T::KIND ? static_cast<T *>(n) : NULL; }
+template <class T> inline T const *node_cast(tree_node const *n)
+  { return n != NULL && n->get_kind() == T::KIND ? static_cast<T const *>(n) : NULL; }
+
+class AstWriter;
+
 #define Program_EXTRAS                          \
-virtual void dump_with_types(ostream&, int) = 0; 
+virtual void dump_with_types(ostream&, int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 
 #define program_EXTRAS                          \
-void dump_with_types(ostream&, int);            
+void dump_with_types(ostream&, int); \
+void dump_binary(AstWriter&);
 
 #define Class__EXTRAS                   \
 virtual Symbol get_filename() = 0;      \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define class__EXTRAS                                 \
 Symbol get_filename() { return filename; }             \
-void dump_with_types(ostream&,int);                    
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&);
 
 
 #define Feature_EXTRAS                                        \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define Feature_SHARED_EXTRAS                                       \
-void dump_with_types(ostream&,int);    
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&);
 
 
 
 
 
 #define Formal_EXTRAS                              \
-virtual void dump_with_types(ostream&,int) = 0;
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define formal_EXTRAS                           \
-void dump_with_types(ostream&,int);
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&);
 
 
 #define Case_EXTRAS                             \
-virtual void dump_with_types(ostream& ,int) = 0;
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define branch_EXTRAS                                   \
-void dump_with_types(ostream& ,int);
+void dump_with_types(ostream& ,int); \
+void dump_binary(AstWriter&);
 
 
 #define Expression_EXTRAS                    \
@@ -94,13 +131,15 @@ Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
 virtual void dump_with_types(ostream&,int) = 0;  \
+virtual void dump_binary(AstWriter&) = 0; \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 
 
 #define Expression_SHARED_EXTRAS           \
-void dump_with_types(ostream&,int); 
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&);
 
 
 #endif
@@ -8,14 +8,14 @@
   #include "cool-tree.h"
   #include "stringtab.h"
   #include "utilities.h"
+  #include "stats.h"
   
-  extern char *curr_filename;
+  extern thread_local char *curr_filename;
   /* Locations */
-  #define YYLTYPE int              /* the type of locations */
-  #define cool_yylloc curr_lineno  /* use the curr_lineno from the lexer
-  for the location of tokens */
+  #define YYLTYPE int              /* the type of locations; next_token
+  uses the curr_lineno from the lexer for the location of tokens */
     
-    extern int node_lineno;          /* set before constructing a tree node
+    extern thread_local int node_lineno; /* set before constructing a tree node
     to whatever you want the line number
     for the tree node to be */
       
@@ -73,16 +73,29 @@
     
     
     void yyerror(char *s);        /*  defined below; called for each parse error */
-    extern int yylex();           /*  the entry point to the lexer  */
+    extern int cool_yylex();      /*  the entry point to the lexer  */
     
     /************************************************************************/
     /*                DONT CHANGE ANYTHING IN THIS SECTION                  */
     
-    Program ast_root;	      /* the result of the parse  */
-    Classes parse_results;        /* for use in semantic analysis */
-    int omerrs = 0;               /* number of errors in lexing and parsing */
+    /* The parser is pure and these are per thread, so that coolc can
+    parse several files at once, one on each thread. */
+    thread_local Program ast_root;	      /* the result of the parse  */
+    thread_local Classes parse_results;   /* for use in semantic analysis */
+    thread_local int omerrs = 0;          /* number of errors in lexing and parsing */
     %}
     
+    %define api.pure
+    %locations
+    
+    %code {
+      /* The parser calls yylex with places for the token's value and
+      location; next_token fills them in from the lexer's globals. */
+      static int next_token(YYSTYPE *lvalp, YYLTYPE *llocp);
+      #undef yylex
+      #define yylex next_token
+    }
+    
     /* A union of all the types that can be the result of parsing actions. */
     %union {
       Boolean boolean;
@@ -421,18 +434,44 @@
     /* end of grammar */
     %%
     
+    /* The lexer keeps these up to date; both are per thread. */
+    thread_local int curr_lineno;
+    thread_local YYSTYPE cool_yylval;
+    
+    static thread_local int last_token;   /* the token yyerror reports */
+    thread_local int parse_tokens;        /* tokens read since it was zeroed */
+    
+    /* Where yyerror reports; coolc collects each file's errors apart. */
+    thread_local ostream *parse_errors = &cerr;
+    
+    /* After more than 50 errors the rest of the input is skipped:
+    next_token reports its end, and yyerror says nothing more. */
+    static int next_token(YYSTYPE *lvalp, YYLTYPE *llocp)
+    {
+      if (omerrs > 50)
+        return last_token = 0;
+      last_token = cool_yylex();
+      if (last_token != 0) {
+        stat_counters.tokens++;
+        parse_tokens++;
+      }
+      *lvalp = cool_yylval;
+      *llocp = curr_lineno;
+      return last_token;
+    }
+    
     /* This function is called automatically when Bison detects a parse error. */
     void yyerror(char *s)
     {
-      extern int curr_lineno;
-      
-      cerr << "\"" << curr_filename << "\", line " << curr_lineno << ": " \
+      if (omerrs > 50)
+        return;
+      *parse_errors << "\"" << curr_filename << "\", line " << curr_lineno << ": " \
       << s << " at or near ";
-      print_cool_token(yychar);
-      cerr << endl;
+      print_cool_token(*parse_errors, last_token);
+      *parse_errors << endl;
       omerrs++;
       
-      if(omerrs>50) {fprintf(stdout, "More than 50 errors\n"); exit(1);}
+      if(omerrs>50) *parse_errors << "More than 50 errors" << endl;
     }
     
     
\ No newline at end of file
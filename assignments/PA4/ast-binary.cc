@@ -0,0 +1,705 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////
+//
+//  ast-binary.cc
+//
+//  Writer and reader for the binary AST format described in
+//  ast-binary.h.  As with dump_with_types, the writer is a virtual
+//  function dump_binary with one implementation per kind of AST node;
+//  the reader is a recursive descent over the node records that
+//  rebuilds the tree with the usual constructor functions.
+//
+//////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "cool.h"
+#include "tree.h"
+#include "cool-tree.h"
+#include "utilities.h"
+#include "ast-binary.h"
+
+extern thread_local int node_lineno;          // defined in tree.cc
+
+static const char magic[] = { '\177', 'A', 'S', 'T' };
+
+//////////////////////////////////////////////////////////////////
+//
+//  Writing
+//
+//////////////////////////////////////////////////////////////////
+
+void AstWriter::put(std::string& buf, unsigned int n)
+{
+  while (n >= 0x80) {
+    buf += (char) ((n & 0x7f) | 0x80);
+    n >>= 7;
+  }
+  buf += (char) n;
+}
+
+//
+// A symbol is entered into the symbol section the first time it is seen;
+// after that only its index is written.
+//
+void AstWriter::symbol(Symbol s, AstTable table)
+{
+  if (s == NULL) {
+    put(nodes, 0);
+    return;
+  }
+  int& i = index[s];
+  if (i == 0) {
+    i = ++num_symbols;
+    put(symbols, table);
+    put(symbols, s->get_len());
+    symbols.append(s->get_string(), s->get_len());
+  }
+  put(nodes, i);
+}
+
+void AstWriter::node(AstKind kind, tree_node *t)
+{
+  put(nodes, kind);
+  put(nodes, t->get_line_number());
+}
+
+void AstWriter::write(ostream& stream)
+{
+  std::string header(magic, sizeof(magic));
+  put(header, AST_BINARY_VERSION);
+  put(header, num_symbols);
+  stream.write(header.data(), header.size());
+  stream.write(symbols.data(), symbols.size());
+  stream.write(nodes.data(), nodes.size());
+  stream.flush();
+}
+
+void dump_ast_binary(ostream& stream, Program p)
+{
+  AstWriter w;
+  p->dump_binary(w);
+  w.write(stream);
+}
+
+void program_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_program, this);
+  w.length(classes->len());
+  for(int i = classes->first(); classes->more(i); i = classes->next(i))
+    classes->nth(i)->dump_binary(w);
+}
+
+void class__class::dump_binary(AstWriter& w)
+{
+  w.node(AST_class_, this);
+  w.id(name);
+  w.id(parent);
+  w.str(filename);
+  w.length(features->len());
+  for(int i = features->first(); features->more(i); i = features->next(i))
+    features->nth(i)->dump_binary(w);
+}
+
+void method_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_method, this);
+  w.id(name);
+  w.length(formals->len());
+  for(int i = formals->first(); formals->more(i); i = formals->next(i))
+    formals->nth(i)->dump_binary(w);
+  w.id(return_type);
+  expr->dump_binary(w);
+}
+
+void attr_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_attr, this);
+  w.id(name);
+  w.id(type_decl);
+  init->dump_binary(w);
+}
+
+void formal_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_formal, this);
+  w.id(name);
+  w.id(type_decl);
+}
+
+void branch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_branch, this);
+  w.id(name);
+  w.id(type_decl);
+  expr->dump_binary(w);
+}
+
+//
+// Every Expression ends with its type, just as dump_with_types ends
+// with dump_type.
+//
+void assign_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_assign, this);
+  w.id(name);
+  expr->dump_binary(w);
+  w.id(type);
+}
+
+void static_dispatch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_static_dispatch, this);
+  expr->dump_binary(w);
+  w.id(type_name);
+  w.id(name);
+  w.length(actual->len());
+  for(int i = actual->first(); actual->more(i); i = actual->next(i))
+    actual->nth(i)->dump_binary(w);
+  w.id(type);
+}
+
+void dispatch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_dispatch, this);
+  expr->dump_binary(w);
+  w.id(name);
+  w.length(actual->len());
+  for(int i = actual->first(); actual->more(i); i = actual->next(i))
+    actual->nth(i)->dump_binary(w);
+  w.id(type);
+}
+
+void cond_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_cond, this);
+  pred->dump_binary(w);
+  then_exp->dump_binary(w);
+  else_exp->dump_binary(w);
+  w.id(type);
+}
+
+void loop_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_loop, this);
+  pred->dump_binary(w);
+  body->dump_binary(w);
+  w.id(type);
+}
+
+void typcase_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_typcase, this);
+  expr->dump_binary(w);
+  w.length(cases->len());
+  for(int i = cases->first(); cases->more(i); i = cases->next(i))
+    cases->nth(i)->dump_binary(w);
+  w.id(type);
+}
+
+void block_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_block, this);
+  w.length(body->len());
+  for(int i = body->first(); body->more(i); i = body->next(i))
+    body->nth(i)->dump_binary(w);
+  w.id(type);
+}
+
+void let_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_let, this);
+  w.id(identifier);
+  w.id(type_decl);
+  init->dump_binary(w);
+  body->dump_binary(w);
+  w.id(type);
+}
+
+void plus_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_plus, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void sub_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_sub, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void mul_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_mul, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void divide_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_divide, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void neg_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_neg, this);
+  e1->dump_binary(w);
+  w.id(type);
+}
+
+void lt_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_lt, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void eq_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_eq, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void leq_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_leq, this);
+  e1->dump_binary(w);
+  e2->dump_binary(w);
+  w.id(type);
+}
+
+void comp_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_comp, this);
+  e1->dump_binary(w);
+  w.id(type);
+}
+
+void int_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_int_const, this);
+  w.integer(token);
+  w.id(type);
+}
+
+void bool_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_bool_const, this);
+  w.boolean(val);
+  w.id(type);
+}
+
+void string_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_string_const, this);
+  w.str(token);
+  w.id(type);
+}
+
+void new__class::dump_binary(AstWriter& w)
+{
+  w.node(AST_new_, this);
+  w.id(type_name);
+  w.id(type);
+}
+
+void isvoid_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_isvoid, this);
+  e1->dump_binary(w);
+  w.id(type);
+}
+
+void no_expr_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_no_expr, this);
+  w.id(type);
+}
+
+void object_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_object, this);
+  w.id(name);
+  w.id(type);
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Reading
+//
+//  The whole input is read into memory first.  Each read_ function
+//  decodes one node: the kind and line number, then the fields in
+//  order.  node_lineno is set just before the node is constructed
+//  (after its children), so that the node gets its own line number.
+//  Malformed input ends the reading: malformed throws, and
+//  read_ast_binary reports the error.
+//
+//////////////////////////////////////////////////////////////////
+
+struct MalformedAst {
+  const char *what;
+};
+
+static void malformed(const char *what = "Malformed binary AST")
+{
+  throw MalformedAst{what};
+}
+
+class AstReader {
+private:
+  std::string buf;
+  size_t pos;
+  // The symbol section, entered into the string tables on first use.
+  struct SymbolRecord { unsigned int table; size_t offset, len; };
+  std::vector<SymbolRecord> records;
+  std::vector<Symbol> symbols;
+
+  unsigned int get();
+  Symbol symbol();
+  int start(int& line);
+public:
+  AstReader(FILE *f);
+  Program read_program();
+  Class_ read_class();
+  Feature read_feature();
+  Formal read_formal();
+  Case read_case();
+  Expression read_expression();
+  Expressions read_expressions();
+  bool at_end() { return pos == buf.size(); }
+};
+
+unsigned int AstReader::get()
+{
+  unsigned int n = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (pos >= buf.size())
+      malformed();
+    unsigned char c = buf[pos++];
+    n |= (unsigned int) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return n;
+  }
+  malformed();
+  return 0;
+}
+
+//
+// Symbols are added to their table when the tree first refers to them
+// rather than when the symbol section is read; that is the order in
+// which they appear in the text format, so either way the tables come
+// out numbered alike.
+//
+Symbol AstReader::symbol()
+{
+  unsigned int i = get();
+  if (i > symbols.size())
+    malformed();
+  if (i == 0)
+    return NULL;
+  if (symbols[i - 1] == NULL) {
+    SymbolRecord& r = records[i - 1];
+    std::string s(buf, r.offset, r.len);
+    char *str = const_cast<char *>(s.c_str());
+    switch (r.table) {
+    case AST_IDTABLE:  symbols[i - 1] = idtable.add_string(str, r.len); break;
+    case AST_STRTABLE: symbols[i - 1] = stringtable.add_string(str, r.len); break;
+    case AST_INTTABLE: symbols[i - 1] = inttable.add_string(str, r.len); break;
+    }
+  }
+  return symbols[i - 1];
+}
+
+int AstReader::start(int& line)
+{
+  int kind = get();
+  line = get();
+  return kind;
+}
+
+AstReader::AstReader(FILE *f) : pos(0)
+{
+  char chunk[BUFSIZ];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    buf.append(chunk, n);
+
+  if (buf.compare(0, sizeof(magic), magic, sizeof(magic)) != 0)
+    malformed();
+  pos = sizeof(magic);
+  if (get() != AST_BINARY_VERSION)
+    malformed("Unsupported binary AST version");
+
+  unsigned int count = get();
+  for (unsigned int i = 0; i < count; i++) {
+    SymbolRecord r;
+    r.table = get();
+    r.len = get();
+    r.offset = pos;
+    if (r.table > AST_INTTABLE || r.len > buf.size() - pos)
+      malformed();
+    pos += r.len;
+    records.push_back(r);
+  }
+  symbols.resize(count, NULL);
+}
+
+Program AstReader::read_program()
+{
+  int line;
+  if (start(line) != AST_program)
+    malformed();
+  Classes classes = nil_Classes();
+  for (unsigned int n = get(); n > 0; n--)
+    classes = append_Classes(classes, single_Classes(read_class()));
+  node_lineno = line;
+  return program(classes);
+}
+
+Class_ AstReader::read_class()
+{
+  int line;
+  if (start(line) != AST_class_)
+    malformed();
+  Symbol name = symbol();
+  Symbol parent = symbol();
+  Symbol filename = symbol();
+  Features features = nil_Features();
+  for (unsigned int n = get(); n > 0; n--)
+    features = append_Features(features, single_Features(read_feature()));
+  node_lineno = line;
+  return class_(name, parent, features, filename);
+}
+
+Feature AstReader::read_feature()
+{
+  int line;
+  switch (start(line)) {
+  case AST_method: {
+    Symbol name = symbol();
+    Formals formals = nil_Formals();
+    for (unsigned int n = get(); n > 0; n--)
+      formals = append_Formals(formals, single_Formals(read_formal()));
+    Symbol return_type = symbol();
+    Expression expr = read_expression();
+    node_lineno = line;
+    return method(name, formals, return_type, expr);
+  }
+  case AST_attr: {
+    Symbol name = symbol();
+    Symbol type_decl = symbol();
+    Expression init = read_expression();
+    node_lineno = line;
+    return attr(name, type_decl, init);
+  }
+  }
+  malformed();
+  return NULL;
+}
+
+Formal AstReader::read_formal()
+{
+  int line;
+  if (start(line) != AST_formal)
+    malformed();
+  Symbol name = symbol();
+  Symbol type_decl = symbol();
+  node_lineno = line;
+  return formal(name, type_decl);
+}
+
+Case AstReader::read_case()
+{
+  int line;
+  if (start(line) != AST_branch)
+    malformed();
+  Symbol name = symbol();
+  Symbol type_decl = symbol();
+  Expression expr = read_expression();
+  node_lineno = line;
+  return branch(name, type_decl, expr);
+}
+
+Expressions AstReader::read_expressions()
+{
+  Expressions exprs = nil_Expressions();
+  for (unsigned int n = get(); n > 0; n--)
+    exprs = append_Expressions(exprs, single_Expressions(read_expression()));
+  return exprs;
+}
+
+Expression AstReader::read_expression()
+{
+  int line;
+  Expression e = NULL;
+  int kind = start(line);
+  switch (kind) {
+  case AST_assign: {
+    Symbol name = symbol();
+    Expression expr = read_expression();
+    node_lineno = line;
+    e = assign(name, expr);
+    break;
+  }
+  case AST_static_dispatch: {
+    Expression expr = read_expression();
+    Symbol type_name = symbol();
+    Symbol name = symbol();
+    Expressions actual = read_expressions();
+    node_lineno = line;
+    e = static_dispatch(expr, type_name, name, actual);
+    break;
+  }
+  case AST_dispatch: {
+    Expression expr = read_expression();
+    Symbol name = symbol();
+    Expressions actual = read_expressions();
+    node_lineno = line;
+    e = dispatch(expr, name, actual);
+    break;
+  }
+  case AST_cond: {
+    Expression pred = read_expression();
+    Expression then_exp = read_expression();
+    Expression else_exp = read_expression();
+    node_lineno = line;
+    e = cond(pred, then_exp, else_exp);
+    break;
+  }
+  case AST_loop: {
+    Expression pred = read_expression();
+    Expression body = read_expression();
+    node_lineno = line;
+    e = loop(pred, body);
+    break;
+  }
+  case AST_typcase: {
+    Expression expr = read_expression();
+    Cases cases = nil_Cases();
+    for (unsigned int n = get(); n > 0; n--)
+      cases = append_Cases(cases, single_Cases(read_case()));
+    node_lineno = line;
+    e = typcase(expr, cases);
+    break;
+  }
+  case AST_block: {
+    Expressions body = read_expressions();
+    node_lineno = line;
+    e = block(body);
+    break;
+  }
+  case AST_let: {
+    Symbol identifier = symbol();
+    Symbol type_decl = symbol();
+    Expression init = read_expression();
+    Expression body = read_expression();
+    node_lineno = line;
+    e = let(identifier, type_decl, init, body);
+    break;
+  }
+  case AST_plus: case AST_sub: case AST_mul: case AST_divide:
+  case AST_lt: case AST_eq: case AST_leq: {
+    Expression e1 = read_expression();
+    Expression e2 = read_expression();
+    node_lineno = line;
+    switch (kind) {
+    case AST_plus:   e = plus(e1, e2); break;
+    case AST_sub:    e = sub(e1, e2); break;
+    case AST_mul:    e = mul(e1, e2); break;
+    case AST_divide: e = divide(e1, e2); break;
+    case AST_lt:     e = lt(e1, e2); break;
+    case AST_eq:     e = eq(e1, e2); break;
+    case AST_leq:    e = leq(e1, e2); break;
+    }
+    break;
+  }
+  case AST_neg: case AST_comp: case AST_isvoid: {
+    Expression e1 = read_expression();
+    node_lineno = line;
+    switch (kind) {
+    case AST_neg:    e = neg(e1); break;
+    case AST_comp:   e = comp(e1); break;
+    case AST_isvoid: e = isvoid(e1); break;
+    }
+    break;
+  }
+  case AST_int_const: {
+    Symbol token = symbol();
+    node_lineno = line;
+    e = int_const(token);
+    break;
+  }
+  case AST_bool_const: {
+    Boolean val = get();
+    // The text reader lexes the value as an integer constant, so it
+    // ends up in the inttable; do the same to keep the tables identical.
+    inttable.add_string((char *) (val ? "1" : "0"));
+    node_lineno = line;
+    e = bool_const(val);
+    break;
+  }
+  case AST_string_const: {
+    Symbol token = symbol();
+    node_lineno = line;
+    e = string_const(token);
+    break;
+  }
+  case AST_new_: {
+    Symbol type_name = symbol();
+    node_lineno = line;
+    e = new_(type_name);
+    break;
+  }
+  case AST_no_expr:
+    node_lineno = line;
+    e = no_expr();
+    break;
+  case AST_object: {
+    Symbol name = symbol();
+    node_lineno = line;
+    e = object(name);
+    break;
+  }
+  default:
+    malformed();
+  }
+  return e->set_type(symbol());
+}
+
+bool is_ast_binary(FILE *f)
+{
+  int c = getc(f);
+  if (c == EOF)
+    return false;
+  ungetc(c, f);
+  return c == (unsigned char) magic[0];
+}
+
+Program read_ast_binary(FILE *f, ostream& errors)
+{
+  try {
+    AstReader reader(f);
+    Program p = reader.read_program();
+    if (!reader.at_end())
+      malformed();
+    return p;
+  } catch (const MalformedAst& e) {
+    errors << e.what << endl;
+    return NULL;
+  }
+}
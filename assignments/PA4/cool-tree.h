@@ -19,7 +19,9 @@
 typedef class Program_class *Program;
 
 class ClassTable;
+class method_class;
 using ObjectEnv = SymbolTable<Symbol, Symbol>; 
+using MethodEnv = SymbolTable<Symbol, method_class const*>;
 
 class Program_class : public tree_node {
 public:
@@ -131,10 +133,12 @@ typedef Cases_class *Cases;
 // define the class for constructors
 // define constructor - program
 class program_class : public Program_class {
-protected:
+public:
    Classes classes;
 public:
+   enum { KIND = NODE_program };
    program_class(Classes a1) {
+      kind = KIND;
       classes = a1;
    }
    Program copy_Program();
@@ -151,13 +155,15 @@ public:
 
 // define constructor - class_
 class class__class : public Class__class {
-protected:
+public:
    Symbol name;
    Symbol parent;
    Features features;
    Symbol filename;
 public:
+   enum { KIND = NODE_class_ };
    class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+      kind = KIND;
       name = a1;
       parent = a2;
       features = a3;
@@ -178,13 +184,15 @@ public:
 
 // define constructor - method
 class method_class : public Feature_class {
-protected:
+public:
    Symbol name;
    Formals formals;
    Symbol return_type;
    Expression expr;
 public:
+   enum { KIND = NODE_method };
    method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+      kind = KIND;
       name = a1;
       formals = a2;
       return_type = a3;
@@ -204,12 +212,14 @@ public:
 
 // define constructor - attr
 class attr_class : public Feature_class {
-protected:
+public:
    Symbol name;
    Symbol type_decl;
    Expression init;
 public:
+   enum { KIND = NODE_attr };
    attr_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
       init = a3;
@@ -228,11 +238,13 @@ public:
 
 // define constructor - formal
 class formal_class : public Formal_class {
-protected:
+public:
    Symbol name;
    Symbol type_decl;
 public:
+   enum { KIND = NODE_formal };
    formal_class(Symbol a1, Symbol a2) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
    }
@@ -250,12 +262,14 @@ public:
 
 // define constructor - branch
 class branch_class : public Case_class {
-protected:
+public:
    Symbol name;
    Symbol type_decl;
    Expression expr;
 public:
+   enum { KIND = NODE_branch };
    branch_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
       expr = a3;
@@ -274,11 +288,13 @@ public:
 
 // define constructor - assign
 class assign_class : public Expression_class {
-protected:
+public:
    Symbol name;
    Expression expr;
 public:
+   enum { KIND = NODE_assign };
    assign_class(Symbol a1, Expression a2) {
+      kind = KIND;
       name = a1;
       expr = a2;
    }
@@ -296,13 +312,15 @@ public:
 
 // define constructor - static_dispatch
 class static_dispatch_class : public Expression_class {
-protected:
+public:
    Expression expr;
    Symbol type_name;
    Symbol name;
    Expressions actual;
 public:
+   enum { KIND = NODE_static_dispatch };
    static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+      kind = KIND;
       expr = a1;
       type_name = a2;
       name = a3;
@@ -322,12 +340,14 @@ public:
 
 // define constructor - dispatch
 class dispatch_class : public Expression_class {
-protected:
+public:
    Expression expr;
    Symbol name;
    Expressions actual;
 public:
+   enum { KIND = NODE_dispatch };
    dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+      kind = KIND;
       expr = a1;
       name = a2;
       actual = a3;
@@ -346,12 +366,14 @@ public:
 
 // define constructor - cond
 class cond_class : public Expression_class {
-protected:
+public:
    Expression pred;
    Expression then_exp;
    Expression else_exp;
 public:
+   enum { KIND = NODE_cond };
    cond_class(Expression a1, Expression a2, Expression a3) {
+      kind = KIND;
       pred = a1;
       then_exp = a2;
       else_exp = a3;
@@ -370,11 +392,13 @@ public:
 
 // define constructor - loop
 class loop_class : public Expression_class {
-protected:
+public:
    Expression pred;
    Expression body;
 public:
+   enum { KIND = NODE_loop };
    loop_class(Expression a1, Expression a2) {
+      kind = KIND;
       pred = a1;
       body = a2;
    }
@@ -392,11 +416,13 @@ public:
 
 // define constructor - typcase
 class typcase_class : public Expression_class {
-protected:
+public:
    Expression expr;
    Cases cases;
 public:
+   enum { KIND = NODE_typcase };
    typcase_class(Expression a1, Cases a2) {
+      kind = KIND;
       expr = a1;
       cases = a2;
    }
@@ -414,10 +440,12 @@ public:
 
 // define constructor - block
 class block_class : public Expression_class {
-protected:
+public:
    Expressions body;
 public:
+   enum { KIND = NODE_block };
    block_class(Expressions a1) {
+      kind = KIND;
       body = a1;
    }
    Expression copy_Expression();
@@ -434,13 +462,15 @@ public:
 
 // define constructor - let
 class let_class : public Expression_class {
-protected:
+public:
    Symbol identifier;
    Symbol type_decl;
    Expression init;
    Expression body;
 public:
+   enum { KIND = NODE_let };
    let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+      kind = KIND;
       identifier = a1;
       type_decl = a2;
       init = a3;
@@ -460,11 +490,13 @@ public:
 
 // define constructor - plus
 class plus_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_plus };
    plus_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -482,11 +514,13 @@ public:
 
 // define constructor - sub
 class sub_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_sub };
    sub_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -504,11 +538,13 @@ public:
 
 // define constructor - mul
 class mul_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_mul };
    mul_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -526,11 +562,13 @@ public:
 
 // define constructor - divide
 class divide_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_divide };
    divide_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -548,10 +586,12 @@ public:
 
 // define constructor - neg
 class neg_class : public Expression_class {
-protected:
+public:
    Expression e1;
 public:
+   enum { KIND = NODE_neg };
    neg_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -568,11 +608,13 @@ public:
 
 // define constructor - lt
 class lt_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_lt };
    lt_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -590,11 +632,13 @@ public:
 
 // define constructor - eq
 class eq_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_eq };
    eq_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -612,11 +656,13 @@ public:
 
 // define constructor - leq
 class leq_class : public Expression_class {
-protected:
+public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_leq };
    leq_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -634,10 +680,12 @@ public:
 
 // define constructor - comp
 class comp_class : public Expression_class {
-protected:
+public:
    Expression e1;
 public:
+   enum { KIND = NODE_comp };
    comp_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -654,10 +702,12 @@ public:
 
 // define constructor - int_const
 class int_const_class : public Expression_class {
-protected:
+public:
    Symbol token;
 public:
+   enum { KIND = NODE_int_const };
    int_const_class(Symbol a1) {
+      kind = KIND;
       token = a1;
    }
    Expression copy_Expression();
@@ -674,10 +724,12 @@ public:
 
 // define constructor - bool_const
 class bool_const_class : public Expression_class {
-protected:
+public:
    Boolean val;
 public:
+   enum { KIND = NODE_bool_const };
    bool_const_class(Boolean a1) {
+      kind = KIND;
       val = a1;
    }
    Expression copy_Expression();
@@ -694,10 +746,12 @@ public:
 
 // define constructor - string_const
 class string_const_class : public Expression_class {
-protected:
+public:
    Symbol token;
 public:
+   enum { KIND = NODE_string_const };
    string_const_class(Symbol a1) {
+      kind = KIND;
       token = a1;
    }
    Expression copy_Expression();
@@ -714,10 +768,12 @@ public:
 
 // define constructor - new_
 class new__class : public Expression_class {
-protected:
+public:
    Symbol type_name;
 public:
+   enum { KIND = NODE_new_ };
    new__class(Symbol a1) {
+      kind = KIND;
       type_name = a1;
    }
    Expression copy_Expression();
@@ -734,10 +790,12 @@ public:
 
 // define constructor - isvoid
 class isvoid_class : public Expression_class {
-protected:
+public:
    Expression e1;
 public:
+   enum { KIND = NODE_isvoid };
    isvoid_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -754,9 +812,11 @@ public:
 
 // define constructor - no_expr
 class no_expr_class : public Expression_class {
-protected:
 public:
+public:
+   enum { KIND = NODE_no_expr };
    no_expr_class() {
+      kind = KIND;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
@@ -772,10 +832,12 @@ public:
 
 // define constructor - object
 class object_class : public Expression_class {
-protected:
+public:
    Symbol name;
 public:
+   enum { KIND = NODE_object };
    object_class(Symbol a1) {
+      kind = KIND;
       name = a1;
    }
    Expression copy_Expression();
@@ -0,0 +1,72 @@
+//
+// hierarchy_stress.cc
+//
+// Times ClassTable::check_hierarchy on one long inheritance chain, in
+// which every class adds a method and an attribute and redefines its
+// parent's method:
+//
+//    class C0 { m0() : Int { 0 }; a0 : Int; };
+//    class C1 inherits C0 { m0() : Int { 0 }; m1() : Int { 0 }; a1 : Int; };
+//    ...
+//
+//    hierarchy_stress [depth]      (depth defaults to 5000)
+//
+// The program is correct, so any error reported is a failure.
+//
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "semant.h"
+
+thread_local char *curr_filename = "<hierarchy_stress>";
+FILE *ast_file;       // not used, but needed to link with the AST reader
+int cool_yydebug;     // not used, but needed to link with handle_flags
+
+static double seconds(clock_t start)
+{
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+static Symbol numbered(const char *prefix, int i)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%s%d", prefix, i);
+  return idtable.add_string(buf);
+}
+
+static Feature method_returning_int(Symbol name)
+{
+  Symbol Int = idtable.add_string("Int");
+  return method(name, nil_Formals(), Int, int_const(inttable.add_string("0")));
+}
+
+int main(int argc, char *argv[]) {
+  int depth = argc > 1 ? atoi(argv[1]) : 5000;
+  Symbol filename = stringtable.add_string("<hierarchy_stress>");
+  Symbol Int = idtable.add_string("Int");
+
+  Classes classes = nil_Classes();
+  for (int i = 0; i < depth; i++) {
+    Features features = single_Features(method_returning_int(numbered("m", i)));
+    if (i > 0)
+      features = append_Features(
+        single_Features(method_returning_int(numbered("m", i - 1))), features);
+    features = append_Features(features,
+      single_Features(attr(numbered("a", i), Int, no_expr())));
+    Symbol parent = i == 0 ? idtable.add_string("Object") : numbered("C", i - 1);
+    classes = append_Classes(classes,
+      single_Classes(class_(numbered("C", i), parent, features, filename)));
+  }
+
+  clock_t start = clock();
+  ClassTable t(classes);
+  double build = seconds(start);
+
+  start = clock();
+  t.check_hierarchy();
+  double check = seconds(start);
+
+  cout << depth << " classes deep: " << build << "s to build the class table, "
+       << check << "s to check the hierarchy" << endl;
+  return t.errors() == 0 ? 0 : 1;
+}
@@ -1,19 +1,34 @@
 #include <stdio.h>
 #include "cool-tree.h"
+#include "ast-binary.h"
+#include "stats.h"
 
 extern Program ast_root;      // root of the abstract syntax tree
 FILE *ast_file = stdin;       // we read the AST from standard input
 extern int ast_yyparse(void); // entry point to the AST parser
+extern int ast_binary;        // write the AST in binary format
 
 int cool_yydebug;     // not used, but needed to link with handle_flags
-char *curr_filename;
+thread_local char *curr_filename;
 
 void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
   handle_flags(argc,argv);
-  ast_yyparse();
-  ast_root->semant();
-  ast_root->dump_with_types(cout,0);
+  begin_phase("read");
+  if (is_ast_binary(ast_file)) {
+    ast_root = read_ast_binary(ast_file, cerr);
+    if (ast_root == NULL)
+      exit(1);
+  } else
+    ast_yyparse();
+  begin_phase("semant");
+  if (ast_root->semant() != 0)
+    exit(1);
+  begin_phase("dump");
+  if (ast_binary)
+    dump_ast_binary(cout, ast_root);
+  else
+    ast_root->dump_with_types(cout,0);
 }
 
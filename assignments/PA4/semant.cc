@@ -3,13 +3,37 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <symtab.h>
 #include "semant.h"
+#include "cool-visitor.h"
 #include "utilities.h"
+#include "stats.h"
 
 
-extern int semant_debug;
-extern char *curr_filename;
+extern thread_local int semant_debug;
+extern thread_local int semant_jobs;   // threads type checking (-j)
+extern thread_local char *semant_cache_dir;  // per-class results (-C)
+extern thread_local char *curr_filename;
+
+// where ClassTable reports errors; per thread, like the parser's
+thread_local ostream *semant_error_stream = &cerr;
+
+// The errors found in one class while the classes are type checked in
+// parallel.  They are reported after the checking, in class order.
+struct ClassErrors {
+    std::ostringstream text;
+    int count = 0;
+};
+
+// where semant_error() puts them on a checking thread; NULL otherwise
+static thread_local ClassErrors *class_errors;
 
 //////////////////////////////////////////////////////////////////////
 //
@@ -17,10 +41,11 @@ extern char *curr_filename;
 //
 // For convenience, a large number of symbols are predefined here.
 // These symbols include the primitive type and method names, as well
-// as fixed names used by the runtime system.
+// as fixed names used by the runtime system.  They are per thread, since
+// each thread may be compiling with string tables of its own.
 //
 //////////////////////////////////////////////////////////////////////
-static Symbol 
+static thread_local Symbol 
     arg,
     arg2,
     Bool,
@@ -82,140 +107,371 @@ static void initialize_constants(void)
     val         = idtable.add_string("_val");
 }
 
-void ClassTable::build_method_table() {
-    std::unordered_map<Symbol, method_class const*> methods;
-    build_method_table(methods, Object);
+void ClassRegistry::add_class(Class_ c) {
+    declared.push_back(c);
 }
 
-void ClassTable::build_method_table(std::unordered_map<Symbol,
-        method_class const*>& methods, Symbol class_node) {
-    
-    std::unordered_map<Symbol, method_class const*> methods_save = methods;
-    
-    Features features = sym_class.at(class_node)->get_features();
+// A vector indexed by idtable index, with room for the symbol's.
+template <class T>
+static void make_room(std::vector<T>& v, Symbol sym, T none) {
+    if (sym->get_index() >= (int) v.size())
+        v.resize(sym->get_index() + 1, none);
+}
 
-    for (int i = 0; i < features->len(); ++i) {
-        Feature f = features->nth(i);
-        method_class const* m = dynamic_cast<method_class const*>(f);
-        if (m)
-            methods[m->get_name()] = m;
+// Walk the tree in preorder with an explicit stack, since generated
+// hierarchies can be far deeper than the C++ stack allows.  Each stack
+// entry is a class (by declaration) and the index of its next subclass
+// to visit.  Then build the ancestor tables for joins.
+void ClassRegistry::number() {
+    int n = declared.size();
+    std::vector<int> declaration;          // by idtable index
+    for (int i = 0; i < n; ++i) {
+        Symbol name = declared[i]->get_name();
+        make_room(declaration, name, -1);
+        if (declaration[name->get_index()] < 0)
+            declaration[name->get_index()] = i;
+    }
+    std::vector<std::vector<int>> subclasses(n);
+    for (int i = 1; i < n; ++i) {
+        Symbol parent = declared[i]->get_parent_name();
+        if (declaration[declared[i]->get_name()->get_index()] != i ||
+                parent->get_index() >= (int) declaration.size())
+            continue;
+        int p = declaration[parent->get_index()];
+        if (p >= 0)
+            subclasses[p].push_back(i);
+    }
+
+    std::vector<std::pair<int, size_t>> stack;
+    std::vector<ClassId> id(n, -1);
+    std::vector<ClassId> parent;
+    id[0] = 0;
+    classes.push_back(declared[0]);
+    parent.push_back(0);
+    stack.push_back(std::make_pair(0, 0));
+    while (!stack.empty()) {
+        int d = stack.back().first;
+        if (stack.back().second < subclasses[d].size()) {
+            int child = subclasses[d][stack.back().second++];
+            id[child] = classes.size();
+            classes.push_back(declared[child]);
+            parent.push_back(id[d]);
+            stack.push_back(std::make_pair(child, 0));
+        } else {
+            subtree_ends.resize(classes.size());
+            subtree_ends[id[d]] = classes.size() - 1;
+            stack.pop_back();
+        }
     }
 
-    m_Table[class_node] = methods;
-    for (Symbol child_class : graph[class_node])
-        build_method_table(methods, child_class);
-    methods_save.swap(methods);
+    int size = classes.size();
+    for (ClassId c = 0; c < size; ++c) {
+        make_room(class_ids, name(c), -1);
+        class_ids[name(c)->get_index()] = c;
+    }
+    ancestors.push_back(parent);
+    for (int k = 1; (1 << k) < size; ++k) {
+        std::vector<ClassId> const& half = ancestors[k - 1];
+        std::vector<ClassId> up(size);
+        for (ClassId c = 0; c < size; ++c)
+            up[c] = half[half[c]];
+        ancestors.push_back(up);
+    }
 }
 
+// The symbol may be from another table (or made after numbering), so
+// the class found must have it as its name.
+ClassId ClassRegistry::id(Symbol class_name) const {
+    if (class_name == nullptr || class_name->get_index() >= (int) class_ids.size())
+        return -1;
+    ClassId c = class_ids[class_name->get_index()];
+    return c >= 0 && name(c) == class_name ? c : -1;
+}
 
-void reachable(std::unordered_map<Symbol, std::vector<Symbol>> const& graph, 
-        std::unordered_set<Symbol>& visited, Symbol node) {
-    if (visited.count(node)) return;
-    visited.insert(node);
-    for (Symbol child : graph.at(node)) {
-        reachable(graph, visited, child);
+// Binary lifting: climb from a by halving steps as long as the class
+// reached is not an ancestor of b; the parent of where it stops is the
+// join.
+ClassId ClassRegistry::join(ClassId a, ClassId b) const {
+    if (conforms(b, a))
+        return a;
+    if (conforms(a, b))
+        return b;
+    for (int k = ancestors.size() - 1; k >= 0; --k) {
+        if (!conforms(b, ancestors[k][a]))
+            a = ancestors[k][a];
     }
+    return ancestors[0][a];
+}
+
+SelectorId ClassRegistry::selector(Symbol name) {
+    SelectorId s = find_selector(name);
+    if (s >= 0)
+        return s;
+    make_room(selector_ids, name, -1);
+    s = selector_names.size();
+    selector_ids[name->get_index()] = s;
+    selector_names.push_back(name);
+    return s;
+}
+
+SelectorId ClassRegistry::find_selector(Symbol name) const {
+    if (name->get_index() >= (int) selector_ids.size())
+        return -1;
+    SelectorId s = selector_ids[name->get_index()];
+    return s >= 0 && selector_names[s] == name ? s : -1;
 }
 
-void ClassTable::check_hierarchy(
-        std::unordered_map<Symbol, method_class const*> methods,
-        std::unordered_set<Symbol> members,
+void MethodLayout::add_class(ClassRegistry& registry, ClassId c) {
+    std::vector<Entry> table;
+    if (c > 0)
+        table = tables[registry.parent(c)];
+
+    Symbol name = registry.name(c);
+    Features features = registry.get_class(c)->get_features();
+    for (int i = 0; i < features->len(); ++i) {
+        method_class const* m = node_cast<method_class>(features->nth(i));
+        if (!m)
+            continue;
+        SelectorId selector = registry.selector(m->get_name());
+        Entry e = { name, m, selector };
+        if ((int) selector_slots.size() <= selector)
+            selector_slots.resize(selector + 1);
+        int s = slot(table, selector);
+        if (s >= 0) {
+            table[s] = e;
+            continue;
+        }
+        s = table.size();
+        table.push_back(e);
+        std::vector<int>& slots = selector_slots[selector];
+        if (std::find(slots.begin(), slots.end(), s) == slots.end())
+            slots.push_back(s);
+    }
+    if ((int) tables.size() <= c)
+        tables.resize(c + 1);
+    tables[c].swap(table);
+}
+
+int MethodLayout::slot(ClassId c, SelectorId selector) const {
+    if (c < 0 || c >= (int) tables.size() || selector < 0)
+        return -1;
+    return slot(tables[c], selector);
+}
+
+// A selector's slots are those of the classes that introduced it; the
+// class has it in one of them if the method there is for the selector.
+int MethodLayout::slot(std::vector<Entry> const& table, SelectorId selector) const {
+    if (selector >= (int) selector_slots.size())
+        return -1;
+    for (int s : selector_slots[selector]) {
+        if (s < (int) table.size() && table[s].selector == selector)
+            return s;
+    }
+    return -1;
+}
+
+// Parents come before their children in ClassId order.
+void ClassTable::build_method_table() {
+    for (ClassId c = 0; c < registry.size(); ++c)
+        methods.add_class(registry, c);
+}
+
+
+// Check the features of class_node against those it inherits: the
+// methods and attributes of its ancestors are bound in the enclosing
+// scopes of methods and members, and its own are added to the current
+// scope.  A method redefined is checked against the nearest definition
+// above; only the first difference in its signature is reported.
+void ClassTable::check_features(MethodEnv& methods, ObjectEnv& members,
         Symbol class_node) const {
     
-    Features features = sym_class.at(class_node)->get_features();
-    std::unordered_map<Symbol, method_class const*> methods_save = methods;
-    std::unordered_set<Symbol> members_save = members;
+    Class_ c = sym_class.at(class_node);
+    Symbol filename = c->get_filename();
 
-    for (int i = 0; i < features->len(); ++i) {
-        Feature f = features->nth(i);
-        attr_class const* a = dynamic_cast<attr_class const*>(f);
+    for (Feature f : *c->get_features()) {
+        attr_class const* a = node_cast<attr_class>(f);
         if (a) {
-            if (members.count(a->get_name())) {
-                semant_error() << "Redefinition of attribute " <<
-                    a->get_name() << " in sub class " << class_node << std::endl;
-            } else {
-                members.insert(a->get_name());
-            }
-            break;
+            Symbol name = a->get_name();
+            if (name == self)
+                semant_error(filename, f) << "'self' cannot be the name of an attribute." << std::endl;
+            else if (members.probe(name))
+                semant_error(filename, f) << "Attribute " << name <<
+                    " is multiply defined in class." << std::endl;
+            else if (members.lookup(name))
+                semant_error(filename, f) << "Attribute " << name <<
+                    " is an attribute of an inherited class." << std::endl;
+            else
+                members.addid(name, a->get_type_decl());
+            continue;
         }
 
-        method_class const* m = dynamic_cast<method_class const*>(f);
-        if (m) {
-            if (methods.count(m->get_name())) {
-                method_class const* m_ref = methods.at(m->get_name());
-                if (m->get_return_type() != m_ref->get_return_type()) {
-                    semant_error() << "Invalid method overload return type" << std::endl;
-                    continue;
-                }
-                Formals formals = m->get_formals();
-                Formals formals_ref = m_ref->get_formals();
-                if (formals->len() != formals_ref->len()) {
-                    semant_error() << "Invalid method overload argument count" << std::endl;
-                    continue;
-                }
-
-                for (int j = 0; j < formals->len(); ++j) {
-                    Formal formal = formals->nth(j);
-                    Formal formal_ref = formals_ref->nth(j);
-                    if (formal->get_type_decl() != formal_ref->get_type_decl()) {
-                        semant_error() << "Invalid method overload argument type" << std::endl;
-                        break;
-                    }
-                }
-            } else {
-                methods[m->get_name()] = m;
+        method_class const* m = node_cast<method_class>(f);
+        if (!m)
+            continue;
+        Symbol name = m->get_name();
+        if (methods.probe(name)) {
+            semant_error(filename, f) << "Method " << name << " is multiply defined." << std::endl;
+            continue;
+        }
+        method_class const* m_ref = methods.lookup(name);
+        methods.addid(name, m);
+        if (!m_ref)
+            continue;
+        if (m->get_return_type() != m_ref->get_return_type()) {
+            semant_error(filename, f) << "In redefined method " << name <<
+                ", return type " << m->get_return_type() <<
+                " is different from original return type " <<
+                m_ref->get_return_type() << "." << std::endl;
+            continue;
+        }
+        Formals formals = m->get_formals();
+        Formals formals_ref = m_ref->get_formals();
+        if (formals->len() != formals_ref->len()) {
+            semant_error(filename, f) << "Incompatible number of formal parameters in redefined method " <<
+                name << "." << std::endl;
+            continue;
+        }
+        for (int j = 0; j < formals->len(); ++j) {
+            Symbol type = formals->nth(j)->get_type_decl();
+            Symbol type_ref = formals_ref->nth(j)->get_type_decl();
+            if (type != type_ref) {
+                semant_error(filename, f) << "In redefined method " << name <<
+                    ", parameter type " << type << " is different from original type " <<
+                    type_ref << std::endl;
+                break;
             }
         }
     }
-
-    for (Symbol child : graph.at(class_node)) {
-        check_hierarchy(methods, members, child);
-    }
-    methods.swap(methods_save);
-    members.swap(members_save);
 }
 
+// Walk the tree from Object in preorder, with a scope per class on the
+// path from Object to the current one, so each feature is bound once and
+// unbound when its class's subtree is done.  The walk keeps its own stack
+// of classes and the index of the next child of each.
 void ClassTable::check_hierarchy() const {
-    std::unordered_map<Symbol, method_class const*> methods;
-    std::unordered_set<Symbol> members;
-    check_hierarchy(methods, members, Object);
+    MethodEnv methods;
+    ObjectEnv members;
+    std::vector<std::pair<Symbol, size_t>> stack;
+
+    methods.enterscope();
+    members.enterscope();
+    check_features(methods, members, Object);
+    stack.push_back(std::make_pair(Object, 0));
+    while (!stack.empty()) {
+        std::vector<Symbol> const& children = graph.at(stack.back().first);
+        if (stack.back().second < children.size()) {
+            Symbol child = children[stack.back().second++];
+            methods.enterscope();
+            members.enterscope();
+            check_features(methods, members, child);
+            stack.push_back(std::make_pair(child, 0));
+        } else {
+            methods.exitscope();
+            members.exitscope();
+            stack.pop_back();
+        }
+    }
 }
 
 
-ClassTable::ClassTable(Classes def_classes) : semant_errors(0) , error_stream(cerr) {
-
-    install_basic_classes();
-
-    for (int i = 0; i < def_classes->len(); ++i) {
-        Class_ cur_class = def_classes->nth(i);
-        if (sym_class.count(cur_class->get_name())) {
-            semant_error() << "Redefinition of class " << cur_class->get_name() << std::endl;
+// Main must define a method main without arguments.
+void ClassTable::check_main() const {
+    ClassId c = registry.id(Main);
+    if (c < 0) {
+        semant_error() << "Class Main is not defined." << std::endl;
+        return;
+    }
+    Class_ main_class = registry.get_class(c);
+    for (Feature f : *main_class->get_features()) {
+        method_class const* m = node_cast<method_class>(f);
+        if (m && m->get_name() == main_meth) {
+            if (m->get_formals()->len() != 0)
+                semant_error(main_class) << "'main' method in class Main should have no arguments." << std::endl;
             return;
         }
-        sym_class[cur_class->get_name()] = cur_class;
-        add_edge(cur_class->get_name(), cur_class->get_parent_name());
     }
+    semant_error(main_class) << "No 'main' method in class Main." << std::endl;
+}
+
+// Install the declared classes and check their inheritance.  A class
+// redefined, or inheriting one that cannot be inherited or is not
+// defined, is reported; a class on (or below) a cycle only when there is
+// no other error, as it is then the one class left unnumbered.  Like the
+// reference checker, the parents and cycles are reported in the reverse
+// of the order declared.
+ClassTable::ClassTable(Classes def_classes) : semant_errors(0) , error_stream(*semant_error_stream) {
 
-    {
-        std::unordered_set<Symbol> visited;
-        reachable(graph, visited, Object);
-        if (visited.size() != sym_class.size()) {
-            semant_error() << "cyclic inheritance found" << std::endl;
+    initialize_constants();
+    install_basic_classes();
+
+    std::vector<Class_> installed;
+    for (Class_ cur_class : *def_classes) {
+        Symbol name = cur_class->get_name();
+        if (name == SELF_TYPE || name == Object || name == IO || name == Int ||
+                name == Bool || name == Str) {
+            semant_error(cur_class) << "Redefinition of basic class " << name << "." << std::endl;
+        } else if (sym_class.count(name)) {
+            semant_error(cur_class) << "Class " << name << " was previously defined." << std::endl;
+        } else {
+            sym_class[name] = cur_class;
+            installed.push_back(cur_class);
         }
     }
+    for (auto c = installed.rbegin(); c != installed.rend(); ++c) {
+        Symbol parent = (*c)->get_parent_name();
+        if (parent == Int || parent == Bool || parent == Str || parent == SELF_TYPE)
+            semant_error(*c) << "Class " << (*c)->get_name() << " cannot inherit class " <<
+                parent << "." << std::endl;
+        else if (!sym_class.count(parent))
+            semant_error(*c) << "Class " << (*c)->get_name() <<
+                " inherits from an undefined class " << parent << "." << std::endl;
+    }
+    for (Class_ c : installed)
+        add_edge(c->get_name(), c->get_parent_name());
+
+    for (Symbol basic : { Object, IO, Int, Bool, Str })
+        registry.add_class(sym_class.at(basic));
+    for (Class_ c : installed)
+        registry.add_class(c);
+    registry.number();
+    if (semant_errors)
+        return;
+    for (auto c = installed.rbegin(); c != installed.rend(); ++c) {
+        if (!is_class((*c)->get_name()))
+            semant_error(*c) << "Class " << (*c)->get_name() << ", or an ancestor of " <<
+                (*c)->get_name() << ", is involved in an inheritance cycle." << std::endl;
+    }
 }
 
-bool ClassTable::type_compare_inclusive(Symbol base_t, Symbol super_t) const {
-    if (super_t == Object)
+bool ClassTable::is_basic_class(ClassId c) const {
+    Symbol name = registry.name(c);
+    return name == Object || name == IO || name == Int || name == Bool || name == Str;
+}
+
+bool ClassTable::conforms(Symbol t, Symbol u, Symbol class_node) const {
+    if (t == u)
         return true;
-    while(base_t != super_t && base_t != Object)
-        base_t = sym_class.at(base_t)->get_parent_name();
-    return base_t == super_t;
+    if (u == SELF_TYPE)
+        return false;
+    if (t == SELF_TYPE)
+        t = class_node;
+    ClassId a = registry.id(t);
+    ClassId b = registry.id(u);
+    return a < 0 || b < 0 || registry.conforms(a, b);
+}
+
+Symbol ClassTable::join(Symbol a, Symbol b, Symbol class_node) const {
+    if (a == b)
+        return a;
+    Symbol lca = lowest_common_ancestor(a == SELF_TYPE ? class_node : a,
+                                        b == SELF_TYPE ? class_node : b);
+    return lca ? lca : Object;
 }
 
-bool ClassTable::type_compare_exclusive(Symbol base_t, Symbol super_t) const {
-    return base_t != super_t &&
-            type_compare_inclusive(base_t, super_t);
+method_class const* ClassTable::find_method(Symbol class_name, Symbol name) const {
+    ClassId c = registry.id(class_name);
+    int slot = methods.slot(c, registry.find_selector(name));
+    return slot < 0 ? NULL : methods.table(c)[slot].method;
 }
 
 void ClassTable::add_edge(Symbol class_id, Symbol parent_id) {
@@ -223,156 +479,663 @@ void ClassTable::add_edge(Symbol class_id, Symbol parent_id) {
     if (!graph.count(class_id)) graph[class_id] = std::vector<Symbol>();
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+// The results cache (-C dir)
+//
+// What checking a class found, its errors and the types it gave the
+// class's expressions, is kept in the file semant.cache in dir, under
+// the class's fingerprint.  That is a hash of the class as dumped (so of
+// its line numbers and file name too) and of the signatures of every
+// class it may depend on: the classes it names, their ancestors, the
+// classes named in their signatures, and so on.  A class found there is
+// not checked again; its errors are reported and its types set from the
+// file.  The file is read once and, after the checking, replaced by one
+// with the results for this program's classes (written under another
+// name and renamed, so that compilations sharing the directory never
+// read one half written).  A directory thus serves one program at a
+// time.
+//
+//////////////////////////////////////////////////////////////////////
+
+// Starts the file; change it when the checker's results change.
+static const char cache_magic[] = "cool semant cache 2";
+
+// 64-bit FNV-1a
+static unsigned long long hash_string(std::string const& s,
+        unsigned long long h = 14695981039346656037ULL) {
+    for (char const* p = s.data(); p != s.data() + s.size(); ++p)
+        h = (h ^ (unsigned char) *p) * 1099511628211ULL;
+    return h;
+}
+
+// What other classes see of a class: its parent and the names and types
+// of its features.
+static std::string signature(Class_ c) {
+    std::ostringstream s;
+    s << c->get_name() << " inherits " << c->get_parent_name() << "\n";
+    for (Feature f : *c->get_features()) {
+        if (attr_class* a = node_cast<attr_class>(f))
+            s << " " << a->get_name() << " : " << a->get_type_decl() << "\n";
+        else if (method_class* m = node_cast<method_class>(f)) {
+            s << " " << m->get_name() << "(";
+            for (Formal x : *m->get_formals())
+                s << " " << x->get_type_decl();
+            s << " ) : " << m->get_return_type() << "\n";
+        }
+    }
+    return s.str();
+}
+
+// The types named in the subtree t.
+static void add_type_names(tree_node* t, std::vector<Symbol>& names) {
+    auto add = [&](tree_node* n) {
+        switch (n->get_kind()) {
+        case NODE_class_: names.push_back(static_cast<class__class*>(n)->parent); break;
+        case NODE_method: names.push_back(static_cast<method_class*>(n)->return_type); break;
+        case NODE_attr: names.push_back(static_cast<attr_class*>(n)->type_decl); break;
+        case NODE_formal: names.push_back(static_cast<formal_class*>(n)->type_decl); break;
+        case NODE_branch: names.push_back(static_cast<branch_class*>(n)->type_decl); break;
+        case NODE_let: names.push_back(static_cast<let_class*>(n)->type_decl); break;
+        case NODE_new_: names.push_back(static_cast<new__class*>(n)->type_name); break;
+        case NODE_static_dispatch:
+            names.push_back(static_cast<static_dispatch_class*>(n)->type_name);
+            break;
+        }
+    };
+    walk_tree(t, add);
+}
+
+// The expressions of class c, in preorder.
+static std::vector<Expression> expressions(Class_ c) {
+    std::vector<Expression> e;
+    auto add = [&](tree_node* n) {
+        if (is_expression(n))
+            e.push_back(static_cast<Expression>(n));
+    };
+    walk_tree(c, add);
+    return e;
+}
+
+class SemantCache {
+public:
+    SemantCache(char* dir, ClassRegistry const& registry);
+    // Whether class c is in the cache; if so, its errors are put in
+    // errors and its expressions' types set.
+    bool load(ClassId c, ClassErrors& errors);
+    // What checking class c found.
+    void store(ClassId c, ClassErrors const& errors);
+    // Replace the file with the classes loaded and stored.
+    void save();
+private:
+    struct Record {
+        int count;                        // errors
+        std::string text;
+        std::vector<std::string> types;   // by expression, "-" for none
+    };
+    std::string path;
+    ClassRegistry const& registry;
+    std::unordered_map<unsigned long long, Record> found;  // in the file
+    std::vector<unsigned long long> fingerprints;   // by ClassId
+    std::vector<Record const*> records;             // by ClassId, to save
+    std::vector<Record> stored;
+    std::vector<unsigned long long> signature_hashes;   // by ClassId
+    std::vector<int> visited;    // by ClassId: 1 + the class last fingerprinted
+    unsigned long long fingerprint(ClassId c);
+    unsigned long long signature_hash(ClassId c);
+};
+
+// The file holds the magic line, then for each class its fingerprint,
+// the number of errors, the length of their text and the number of
+// expressions on a line, the text, and the expressions' types one per
+// line.
+SemantCache::SemantCache(char* dir, ClassRegistry const& r)
+    : path(std::string(dir) + "/semant.cache"), registry(r),
+      fingerprints(r.size()), records(r.size()), signature_hashes(r.size()),
+      visited(r.size()) {
+    mkdir(dir, 0777);
+    stored.reserve(r.size());
+    std::ifstream in(path);
+    std::string magic;
+    if (!in || !std::getline(in, magic) || magic != cache_magic)
+        return;
+    unsigned long long h;
+    Record record;
+    size_t length, n;
+    while (in >> std::hex >> h >> std::dec >> record.count >> length >> n
+           && in.get() == '\n') {
+        record.text.assign(length, '\0');
+        record.types.resize(n);
+        if (!in.read(&record.text[0], length))
+            break;
+        for (size_t i = 0; i < n; ++i)
+            in >> record.types[i];
+        if (!in)
+            break;
+        found[h] = record;
+    }
+}
+
+unsigned long long SemantCache::signature_hash(ClassId c) {
+    if (signature_hashes[c] == 0)
+        signature_hashes[c] = hash_string(signature(registry.get_class(c))) | 1;
+    return signature_hashes[c];
+}
+
+// The hashes of the signatures of the classes c depends on are added,
+// so that their order does not matter.
+unsigned long long SemantCache::fingerprint(ClassId c) {
+    if (fingerprints[c] != 0)
+        return fingerprints[c];
+    std::ostringstream text;
+    registry.get_class(c)->dump(text, 0);
+    unsigned long long h = hash_string(text.str(), hash_string(cache_magic));
+
+    std::vector<Symbol> names(1, registry.name(c));
+    add_type_names(registry.get_class(c), names);
+    std::vector<Symbol> undefined;       // few: SELF_TYPE and typos
+    while (!names.empty()) {
+        Symbol name = names.back();
+        names.pop_back();
+        ClassId d = registry.id(name);
+        if (d < 0) {
+            if (std::find(undefined.begin(), undefined.end(), name) == undefined.end()) {
+                undefined.push_back(name);
+                h += hash_string(std::string(name->get_string()) + " undefined");
+            }
+            continue;
+        }
+        if (visited[d] == c + 1)
+            continue;
+        visited[d] = c + 1;
+        h += signature_hash(d);
+        Class_ dc = registry.get_class(d);
+        names.push_back(dc->get_parent_name());
+        for (Feature f : *dc->get_features()) {
+            if (attr_class* a = node_cast<attr_class>(f))
+                names.push_back(a->get_type_decl());
+            else if (method_class* m = node_cast<method_class>(f)) {
+                names.push_back(m->get_return_type());
+                for (Formal x : *m->get_formals())
+                    names.push_back(x->get_type_decl());
+            }
+        }
+    }
+    return fingerprints[c] = h ? h : 1;
+}
+
+bool SemantCache::load(ClassId c, ClassErrors& errors) {
+    auto r = found.find(fingerprint(c));
+    if (r == found.end())
+        return false;
+    std::vector<Expression> exprs = expressions(registry.get_class(c));
+    if (exprs.size() != r->second.types.size())
+        return false;
+    for (size_t i = 0; i < exprs.size(); ++i) {
+        std::string const& t = r->second.types[i];
+        exprs[i]->set_type(t == "-" ? NULL :
+            idtable.add_string(const_cast<char*>(t.c_str())));
+    }
+    errors.text << r->second.text;
+    errors.count = r->second.count;
+    records[c] = &r->second;
+    return true;
+}
+
+void SemantCache::store(ClassId c, ClassErrors const& errors) {
+    Record record;
+    record.count = errors.count;
+    record.text = errors.text.str();
+    for (Expression e : expressions(registry.get_class(c)))
+        record.types.push_back(e->get_type() ? e->get_type()->get_string() : "-");
+    stored.push_back(record);
+    records[c] = &stored.back();
+}
+
+void SemantCache::save() {
+    static std::atomic<unsigned> serial(0);
+    std::ostringstream tmp;
+    tmp << path << ".tmp" << getpid() << "." << serial++;
+    std::ofstream out(tmp.str());
+    out << cache_magic << "\n";
+    for (ClassId c = 0; c < registry.size(); ++c) {
+        Record const* r = records[c];
+        if (!r)
+            continue;
+        out << std::hex << fingerprint(c) << std::dec << " " << r->count << " "
+            << r->text.size() << " " << r->types.size() << "\n" << r->text;
+        for (std::string const& t : r->types)
+            out << t << "\n";
+    }
+    out.close();
+    if (out)
+        rename(tmp.str().c_str(), path.c_str());
+    else
+        unlink(tmp.str().c_str());
+}
+
+// Type check the declared classes (the basic ones have no bodies to
+// check), in preorder, on semant_jobs threads (0 for one per processor),
+// except those found in the cache (-C).  The classes are independent once
+// the method tables are built: each thread takes the next unchecked class
+// from the worklist and checks it in an environment of its own.  A class's
+// errors are kept apart and reported afterwards in preorder, so the output
+// does not depend on the number of threads or on what was cached.
 void ClassTable::type_check() const {
-    ObjectEnv object_env;
-    type_check(object_env, Object);
+    int n = registry.size();
+    std::vector<ClassErrors> errors(n);
+    std::vector<ClassId> worklist;
+    SemantCache* cache = semant_cache_dir ?
+        new SemantCache(semant_cache_dir, registry) : NULL;
+    for (ClassId c = 0; c < n; ++c) {
+        if (is_basic_class(c))
+            continue;
+        if (cache && cache->load(c, errors[c]))
+            stat_counters.semant_cached++;
+        else
+            worklist.push_back(c);
+    }
+    int m = worklist.size();
+    int jobs = semant_jobs > 0 ? semant_jobs : std::thread::hardware_concurrency();
+    if (jobs > m)
+        jobs = m;
+
+    if (jobs <= 1) {
+        ObjectEnv object_env;
+        std::vector<ClassId> scopes;
+        for (ClassId c : worklist) {
+            class_errors = &errors[c];
+            type_check(object_env, scopes, c);
+        }
+        class_errors = NULL;
+    } else {
+        // The threads get the predefined symbols from idtable, which is
+        // locked meanwhile; the symbol table entries go to arenas of their
+        // own.
+        std::atomic<int> next(0);
+        StringTables *tables = string_tables;
+        idtable.begin_concurrent();
+        auto work = [&]() {
+            Arena arena;
+            Arena *old_arena = compilation_arena;
+            string_tables = tables;
+            compilation_arena = &arena;
+            initialize_constants();
+            {
+                ObjectEnv object_env;
+                std::vector<ClassId> scopes;
+                for (int i; (i = next++) < m; ) {
+                    class_errors = &errors[worklist[i]];
+                    type_check(object_env, scopes, worklist[i]);
+                }
+                class_errors = NULL;
+            }
+            compilation_arena = old_arena;
+            merge_counters();
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < jobs; ++t)
+            threads.emplace_back(work);
+        work();
+        for (std::thread& t : threads)
+            t.join();
+        idtable.end_concurrent();
+    }
+
+    if (cache) {
+        for (ClassId c : worklist)
+            cache->store(c, errors[c]);
+        cache->save();
+        delete cache;
+    }
+    for (int i = 0; i < n; ++i) {
+        error_stream << errors[i].text.str();
+        semant_errors += errors[i].count;
+    }
 }
 
-void ClassTable::type_check(ObjectEnv& object_env, Symbol class_node) const {
-    object_env.enterscope();
-    Features features = sym_class.at(class_node)->get_features();
+// Those attributes of class c that check_features accepted.
+void ClassTable::add_attributes(ObjectEnv& object_env, ClassId c) const {
+    Features features = registry.get_class(c)->get_features();
     for (int i = 0; i < features->len(); ++i) {
         Feature f = features->nth(i);
-        attr_class const* a = dynamic_cast<attr_class const*>(f);
-        if (a) object_env.addid(a->get_name(), a->get_type_decl());
+        attr_class const* a = node_cast<attr_class>(f);
+        if (a && a->get_name() != self && !object_env.probe(a->get_name()))
+            object_env.addid(a->get_name(), a->get_type_decl());
     }
-    for (int i = 0; i < features->len(); ++i) {
-        Feature f = features->nth(i);
+}
 
+// Checks the body of a feature of class_node against its declared type.
+struct FeatureChecker : TreeVisitor<FeatureChecker> {
+    Symbol class_node;
+    ObjectEnv& object_env;
+    ClassTable const& class_tbl;
+
+    FeatureChecker(Symbol c, ObjectEnv& env, ClassTable const& tbl)
+        : class_node(c), object_env(env), class_tbl(tbl) { }
+
+    void visit_attr(attr_class* a) {
+        Symbol type = a->get_type_decl();
+        if (type != SELF_TYPE && !class_tbl.is_class(type))
+            class_tbl.class_error(class_node, a) << "Class " << type << " of attribute " <<
+                a->get_name() << " is undefined." << std::endl;
+        Expression init = a->get_init();
+        init->check_type(class_node, object_env, class_tbl);
+        if (!class_tbl.conforms(init->get_type(), type, class_node))
+            class_tbl.class_error(class_node, a) << "Inferred type " << init->get_type() <<
+                " of initialization of attribute " << a->get_name() <<
+                " does not conform to declared type " << type << "." << std::endl;
+    }
 
-        attr_class const* a = dynamic_cast<attr_class const*>(f);
-        if (a) {
-            a->get_init()->check_type(class_node, object_env, *this);
-            if (a->get_init()->get_type() != a->get_type_decl())
-                semant_error() << "Invalid Type for Assignment" << std::endl;
-            continue;
+    void visit_method(method_class* m) {
+        object_env.enterscope();
+        for (Formal x : *m->get_formals()) {
+            Symbol name = x->get_name();
+            Symbol type = x->get_type_decl();
+            if (name == ::self) {
+                class_tbl.class_error(class_node, x) <<
+                    "'self' cannot be the name of a formal parameter." << std::endl;
+                continue;
+            }
+            if (type == SELF_TYPE)
+                class_tbl.class_error(class_node, x) << "Formal parameter " << name <<
+                    " cannot have type SELF_TYPE." << std::endl;
+            else if (!class_tbl.is_class(type))
+                class_tbl.class_error(class_node, x) << "Class " << type <<
+                    " of formal parameter " << name << " is undefined." << std::endl;
+            if (object_env.probe(name))
+                class_tbl.class_error(class_node, x) << "Formal parameter " << name <<
+                    " is multiply defined." << std::endl;
+            else
+                object_env.addid(name, type);
         }
+        Symbol return_type = m->get_return_type();
+        bool defined = return_type == SELF_TYPE || class_tbl.is_class(return_type);
+        if (!defined)
+            class_tbl.class_error(class_node, m) << "Undefined return type " << return_type <<
+                " in method " << m->get_name() << "." << std::endl;
+        Expression body = m->get_expr();
+        body->check_type(class_node, object_env, class_tbl);
+        if (defined && !class_tbl.conforms(body->get_type(), return_type, class_node))
+            class_tbl.class_error(class_node, m) << "Inferred return type " << body->get_type() <<
+                " of method " << m->get_name() << " does not conform to declared return type " <<
+                return_type << "." << std::endl;
+        object_env.exitscope();
+    }
+};
+
+// Check class c.  object_env holds a scope with the attributes of each
+// class in scopes, a path down from Object left by the class checked
+// before; the scopes of the classes off c's path are exited, and those
+// of its missing ancestors (and its own) entered.  Checking the classes
+// in ClassId order, each scope is entered once per thread.  Object's
+// scope binds self too.
+void ClassTable::type_check(ObjectEnv& object_env, std::vector<ClassId>& scopes,
+        ClassId c) const {
+    while (!scopes.empty() && !registry.conforms(c, scopes.back())) {
+        object_env.exitscope();
+        scopes.pop_back();
+    }
+    std::vector<ClassId> missing;
+    for (ClassId a = c; scopes.empty() || a != scopes.back(); a = registry.parent(a)) {
+        missing.push_back(a);
+        if (a == 0)
+            break;
+    }
+    for (auto a = missing.rbegin(); a != missing.rend(); ++a) {
+        object_env.enterscope();
+        if (*a == 0)
+            object_env.addid(self, SELF_TYPE);
+        add_attributes(object_env, *a);
+        scopes.push_back(*a);
+    }
+
+    FeatureChecker checker(registry.name(c), object_env, *this);
+    for (Feature f : *registry.get_class(c)->get_features())
+        checker.visit(f);
+}
 
-        method_class const* m = dynamic_cast<method_class const*>(f);
-        if (m) {
-            m->get_expr()->check_type(class_node, object_env, *this);
-            if (m->get_expr()->get_type() != m->get_return_type())
-                semant_error() << "Invalid Type for Method" << std::endl;
+// The actuals of a dispatch to method (NULL if there is none) of the
+// class named at, once checked: their number and types against the
+// method's formals.  The dispatch's type is the method's return type,
+// with SELF_TYPE the type of the dispatch's receiver of type self_type.
+static Symbol check_call(Symbol class_node, ClassTable const& class_tbl,
+        Expression call, method_class const* method, Symbol self_type,
+        Symbol name, Expressions actual) {
+    Formals formals = method->get_formals();
+    if (formals->len() != actual->len()) {
+        class_tbl.class_error(class_node, call) << "Method " << name <<
+            " called with wrong number of arguments." << std::endl;
+    } else {
+        for (int i = 0; i < actual->len(); ++i) {
+            Formal x = formals->nth(i);
+            Symbol t = actual->nth(i)->get_type();
+            if (!class_tbl.conforms(t, x->get_type_decl(), class_node))
+                class_tbl.class_error(class_node, call) << "In call of method " << name <<
+                    ", type " << t << " of parameter " << x->get_name() <<
+                    " does not conform to declared type " << x->get_type_decl() <<
+                    "." << std::endl;
         }
     }
-    object_env.exitscope();
+    Symbol return_type = method->get_return_type();
+    return return_type == SELF_TYPE ? self_type : return_type;
 }
 
 void assign_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
+    if (name == self)
+        class_tbl.class_error(class_node, this) << "Cannot assign to 'self'." << std::endl;
+    Symbol decl_type = object_env.lookup(name);
+    if (decl_type == nullptr)
+        class_tbl.class_error(class_node, this) << "Assignment to undeclared variable " <<
+            name << "." << std::endl;
     expr->check_type(class_node, object_env, class_tbl);
-
-    if (class_tbl.type_compare_inclusive(expr->get_type(), object_env.lookup(name))) {
-        type = expr->get_type();
-    } else {
-        type = object_env.lookup(name);
-        class_tbl.semant_error() << "Invalid type for assignment" << std::endl;
-    }
+    type = expr->get_type();
+    if (decl_type != nullptr && !class_tbl.conforms(type, decl_type, class_node))
+        class_tbl.class_error(class_node, this) << "Type " << type <<
+            " of assigned expression does not conform to declared type " << decl_type <<
+            " of identifier " << name << "." << std::endl;
 }
 
 void static_dispatch_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
+    expr->check_type(class_node, object_env, class_tbl);
+    for (Expression e : *actual)
+        e->check_type(class_node, object_env, class_tbl);
 
+    type = Object;
+    if (type_name == SELF_TYPE) {
+        class_tbl.class_error(class_node, this) << "Static dispatch to SELF_TYPE." << std::endl;
+        return;
+    }
+    if (!class_tbl.is_class(type_name)) {
+        class_tbl.class_error(class_node, this) << "Static dispatch to undefined class " <<
+            type_name << "." << std::endl;
+        return;
+    }
+    if (!class_tbl.conforms(expr->get_type(), type_name, class_node))
+        class_tbl.class_error(class_node, this) << "Expression type " << expr->get_type() <<
+            " does not conform to declared static dispatch type " << type_name << "." << std::endl;
+    method_class const* method = class_tbl.find_method(type_name, name);
+    if (method == nullptr) {
+        class_tbl.class_error(class_node, this) << "Static dispatch to undefined method " <<
+            name << "." << std::endl;
+        return;
+    }
+    type = check_call(class_node, class_tbl, this, method, expr->get_type(), name, actual);
 }
 
 void dispatch_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
     expr->check_type(class_node, object_env, class_tbl);
-    for (int i= 0; i < actual->len(); ++i)
-        actual->nth(i)->check_type(class_node, object_env, class_tbl);
+    for (Expression e : *actual)
+        e->check_type(class_node, object_env, class_tbl);
 
+    type = Object;
     Symbol call_type = (expr->get_type() == SELF_TYPE ? class_node : expr->get_type());
-    if (!class_tbl.m_Table.at(call_type).count(name)) {
-        class_tbl.semant_error() << "Undefined reference to method in dispatch" << std::endl;
+    if (!class_tbl.is_class(call_type)) {
+        class_tbl.class_error(class_node, this) << "Dispatch on undefined class " <<
+            call_type << "." << std::endl;
         return;
     }
-
-    method_class const* ref_method = class_tbl.m_Table.at(call_type).at(name);   
-    if (ref_method->get_formals()->len() != actual->len()) {
-        class_tbl.semant_error() << "Incorrect number of arguments in method dispatch" << std::endl;
+    method_class const* method = class_tbl.find_method(call_type, name);
+    if (method == nullptr) {
+        class_tbl.class_error(class_node, this) << "Dispatch to undefined method " <<
+            name << "." << std::endl;
         return;
     }
-
-    for (int i = 0; i <= actual->len(); ++i) {
-        if (i < actual->len()) {
-            if (!class_tbl.type_compare_inclusive(ref_method->get_formals()->nth(i)->get_type_decl(),
-                    actual->nth(i)->get_type())) {
-                class_tbl.semant_error() << "Incompatible argument type in method dispatch" << std::endl;
-            }
-        }
-    }
-
-    type = ref_method->get_return_type() == SELF_TYPE ? expr->get_type() : ref_method->get_return_type();
+    type = check_call(class_node, class_tbl, this, method, expr->get_type(), name, actual);
 }
 
 void cond_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
     pred->check_type(class_node, object_env, class_tbl);
-    if (pred->get_type() != Bool) {
-        class_tbl.semant_error() << "If predicate expression type must be Boolean" << std::endl;
-    }
+    if (pred->get_type() != Bool)
+        class_tbl.class_error(class_node, this) << "Predicate of 'if' does not have type Bool." << std::endl;
     then_exp->check_type(class_node, object_env, class_tbl);
     else_exp->check_type(class_node, object_env, class_tbl);
-    type = class_tbl.lowest_common_ancestor({then_exp->get_type(), else_exp->get_type()});
+    type = class_tbl.join(then_exp->get_type(), else_exp->get_type(), class_node);
 }
 
 void loop_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    pred->check_type(class_node, object_env, class_tbl);
+    if (pred->get_type() != Bool)
+        class_tbl.class_error(class_node, this) << "Loop condition does not have type Bool." << std::endl;
+    body->check_type(class_node, object_env, class_tbl);
+    type = Object;
 }
 
 
 void typcase_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    expr->check_type(class_node, object_env, class_tbl);
+    std::vector<Symbol> seen;
+    type = nullptr;
+    for (Case c : *cases) {
+        branch_class* b = static_cast<branch_class*>(c);
+        if (b->name == self)
+            class_tbl.class_error(class_node, b) << "'self' bound in 'case'." << std::endl;
+        if (b->type_decl == SELF_TYPE)
+            class_tbl.class_error(class_node, b) << "Identifier " << b->name <<
+                " declared with type SELF_TYPE in case branch." << std::endl;
+        else if (!class_tbl.is_class(b->type_decl))
+            class_tbl.class_error(class_node, b) << "Class " << b->type_decl <<
+                " of case branch is undefined." << std::endl;
+        if (std::find(seen.begin(), seen.end(), b->type_decl) != seen.end())
+            class_tbl.class_error(class_node, b) << "Duplicate branch " << b->type_decl <<
+                " in case statement." << std::endl;
+        else
+            seen.push_back(b->type_decl);
+
+        object_env.enterscope();
+        if (b->name != self)
+            object_env.addid(b->name, b->type_decl);
+        b->expr->check_type(class_node, object_env, class_tbl);
+        object_env.exitscope();
+        Symbol t = b->expr->get_type();
+        type = type ? class_tbl.join(type, t, class_node) : t;
+    }
 }
 
 
 void block_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    for (Expression e : *body) {
+        e->check_type(class_node, object_env, class_tbl);
+        type = e->get_type();
+    }
 }
 
 
 void let_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
+    if (identifier == self)
+        class_tbl.class_error(class_node, this) << "'self' cannot be bound in a 'let' expression." << std::endl;
+    if (type_decl != SELF_TYPE && !class_tbl.is_class(type_decl))
+        class_tbl.class_error(class_node, this) << "Class " << type_decl <<
+            " of let-bound identifier " << identifier << " is undefined." << std::endl;
+    init->check_type(class_node, object_env, class_tbl);
+    if (!class_tbl.conforms(init->get_type(), type_decl, class_node))
+        class_tbl.class_error(class_node, this) << "Inferred type " << init->get_type() <<
+            " of initialization of " << identifier <<
+            " does not conform to identifier's declared type " << type_decl << "." << std::endl;
 
+    object_env.enterscope();
+    if (identifier != self)
+        object_env.addid(identifier, type_decl);
+    body->check_type(class_node, object_env, class_tbl);
+    object_env.exitscope();
+    type = body->get_type();
 }
 
+// Check the operands of an arithmetic operator or a comparison, which
+// must both be Int.
+static void check_int_operands(Symbol class_node, ObjectEnv& object_env,
+        ClassTable const& class_tbl, Expression e, Expression e1,
+        Expression e2, char const* op) {
+    e1->check_type(class_node, object_env, class_tbl);
+    e2->check_type(class_node, object_env, class_tbl);
+    if (e1->get_type() != Int || e2->get_type() != Int)
+        class_tbl.class_error(class_node, e) << "non-Int arguments: " << e1->get_type() <<
+            " " << op << " " << e2->get_type() << std::endl;
+}
 
 void plus_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "+");
+    type = Int;
 }
 
 
 void sub_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "-");
+    type = Int;
 }
 
 void mul_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "*");
+    type = Int;
 }
 
 
 void divide_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "/");
+    type = Int;
 }
 
 void neg_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    e1->check_type(class_node, object_env, class_tbl);
+    if (e1->get_type() != Int)
+        class_tbl.class_error(class_node, this) << "Argument of '~' has type " <<
+            e1->get_type() << " instead of Int." << std::endl;
+    type = Int;
 }
 
 
 void lt_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "<");
+    type = Bool;
 }
 
 
+// Objects of any types may be compared, except an Int, Bool or String
+// with an object of another type.
 void eq_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    e1->check_type(class_node, object_env, class_tbl);
+    e2->check_type(class_node, object_env, class_tbl);
+    Symbol t1 = e1->get_type();
+    Symbol t2 = e2->get_type();
+    if (t1 != t2 && (t1 == Int || t1 == Bool || t1 == Str ||
+                     t2 == Int || t2 == Bool || t2 == Str))
+        class_tbl.class_error(class_node, this) << "Illegal comparison with a basic type." << std::endl;
+    type = Bool;
 }
 
 
 void leq_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    check_int_operands(class_node, object_env, class_tbl, this, e1, e2, "<=");
+    type = Bool;
 }
 
 
 void comp_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    e1->check_type(class_node, object_env, class_tbl);
+    if (e1->get_type() != Bool)
+        class_tbl.class_error(class_node, this) << "Argument of 'not' has type " <<
+            e1->get_type() << " instead of Bool." << std::endl;
+    type = Bool;
 }
 
 
@@ -389,52 +1152,51 @@ void string_const_class::check_type(Symbol class_node, ObjectEnv& object_env, Cl
 }
 
 void new__class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-    if (type_name == SELF_TYPE) {
-        type = class_node;
-        // type = SELF_TYPE;
-    } else {
+    if (type_name == SELF_TYPE || class_tbl.is_class(type_name)) {
         type = type_name;
+    } else {
+        class_tbl.class_error(class_node, this) << "'new' used with undefined class " <<
+            type_name << "." << std::endl;
+        type = Object;
     }
 }
 
 
 void isvoid_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    e1->check_type(class_node, object_env, class_tbl);
+    type = Bool;
 }
 
 void no_expr_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
-
+    type = No_type;
 }
 
 void object_class::check_type(Symbol class_node, ObjectEnv& object_env, ClassTable const& class_tbl) {
     Symbol decl_type = object_env.lookup(name);
     if (decl_type == nullptr) {
-        class_tbl.semant_error() << "Undefined object identifier " << name << std::endl;
-        type = No_type;
+        class_tbl.class_error(class_node, this) << "Undeclared identifier " << name << "." << std::endl;
+        type = Object;
     } else {
         type = decl_type;
     }
 }
 
-Symbol ClassTable::lowest_common_ancestor(std::unordered_set<Symbol> const& classes) const {
-    std::unordered_set<Symbol> classes_save(classes);
-    return lowest_common_ancestor(classes_save, Object);
+Symbol ClassTable::lowest_common_ancestor(Symbol a, Symbol b) const {
+    Symbol classes[] = { a, b };
+    return lowest_common_ancestor(classes, 2);
 }
 
-Symbol ClassTable::lowest_common_ancestor(std::unordered_set<Symbol>& classes, Symbol class_node) const {
-    if (classes.count(class_node)) {
-        classes.erase(class_node);
-        if (classes.empty())
-            return class_node;
+Symbol ClassTable::lowest_common_ancestor(Symbol const* classes, int n) const {
+    ClassId lca = -1;
+    for (int i = 0; i < n; ++i) {
+        ClassId c = registry.id(classes[i]);
+        if (c < 0)
+            return nullptr;
+        lca = lca < 0 ? c : registry.join(lca, c);
     }
-    for (Symbol child_class : graph.at(class_node)) {
-        Symbol lca = lowest_common_ancestor(classes, child_class);
-        if (lca) return lca;
-    }
-    return classes.empty() ? class_node : nullptr;
+    return lca < 0 ? nullptr : registry.name(lca);
 }
 
-
 void ClassTable::install_basic_classes() {
 
     // The tree package uses these globals to annotate the classes built below.
@@ -559,21 +1321,33 @@ void ClassTable::install_basic_classes() {
 //    ostream& ClassTable::semant_error(Symbol filename, tree_node *t)  
 //       print a line number and filename
 //
+// and class_error(class_node, t), which finds the filename from the
+// class.
+//
 ///////////////////////////////////////////////////////////////////
 
-ostream& ClassTable::semant_error(Class_ c)
+ostream& ClassTable::semant_error(Class_ c) const
 {                                                             
     return semant_error(c->get_filename(),c);
 }    
 
-ostream& ClassTable::semant_error(Symbol filename, tree_node *t)
+ostream& ClassTable::semant_error(Symbol filename, tree_node *t) const
 {
-    error_stream << filename << ":" << t->get_line_number() << ": ";
-    return semant_error();
+    return semant_error() << filename << ":" << t->get_line_number() << ": ";
+}
+
+ostream& ClassTable::class_error(Symbol class_node, tree_node *t) const
+{
+    return semant_error(registry.get_class(registry.id(class_node))->get_filename(), t);
 }
 
 ostream& ClassTable::semant_error() const
 {                                                 
+    stat_counters.semant_errors++;
+    if (class_errors) {
+        class_errors->count++;
+        return class_errors->text;
+    }
     semant_errors++;                            
     return error_stream;
 } 
@@ -592,25 +1366,33 @@ ostream& ClassTable::semant_error() const
      You are free to first do 1), make sure you catch all semantic
      errors. Part 2) can be done in a second stage, when you want
      to build mycoolc.
+
+     semant returns the number of errors found (after reporting them);
+     the compiler stops if there are any.  Otherwise the class table is
+     kept in class_table, so that the code generator can use its classes,
+     their numbering and their method layout instead of making its own.
  */
-void program_class::semant()
+int program_class::semant()
 {
-    initialize_constants();
-
     /* ClassTable constructor may do some semantic analysis */
     ClassTable *classtable = new ClassTable(classes);
-    classtable->check_hierarchy();
     if (classtable->errors())
         goto printerrors;
+    classtable->check_hierarchy();
+    classtable->check_main();
     classtable->build_method_table();
     classtable->type_check(); 
-    /* some semantic analysis code may go here */
 
     printerrors:
-        if (classtable->errors()) {
-        cerr << "Compilation halted due to static semantic errors." << endl;
-        exit(1);
+    int errors = classtable->errors();
+    if (errors) {
+        *semant_error_stream << "Compilation halted due to static semantic errors." << endl;
+        delete classtable;
+    } else {
+        delete class_table;
+        class_table = classtable;
     }
+    return errors;
 }
 
 
@@ -17,8 +17,81 @@
 class ClassTable;
 typedef ClassTable *ClassTableP;
 
-using MethodTable = std::unordered_map<Symbol,
-            std::unordered_map<Symbol, method_class const*>>;
+// Dense numbers for the classes and the method names (selectors), so
+// that what is known about them can be kept in vectors.  A ClassId is
+// the class's number in a preorder walk of the inheritance tree from
+// Object (0), with each class's subclasses in the order they were
+// declared, and is used as the runtime class tag.  Because a subtree's
+// numbers are consecutive, B conforms to A exactly when
+// A <= B <= subtree_end(A).  A SelectorId is given the first time a
+// name is asked for.
+//
+// A name is mapped to its number through its index in idtable, with
+// no hashing.
+typedef int ClassId;
+typedef int SelectorId;
+
+class ClassRegistry {
+public:
+  // The classes, in the order declared, Object first.
+  void add_class(Class_ c);
+  // Number the classes added; those not below Object (whose parent is
+  // missing, or which are on a cycle) get no number.
+  void number();
+
+  int size() const { return classes.size(); }
+  ClassId id(Symbol class_name) const;     // -1 if not a numbered class
+  Symbol name(ClassId c) const { return classes[c]->get_name(); }
+  Class_ get_class(ClassId c) const { return classes[c]; }
+  ClassId parent(ClassId c) const { return ancestors[0][c]; } // Object's: 0
+  ClassId subtree_end(ClassId c) const { return subtree_ends[c]; }
+  bool conforms(ClassId b, ClassId a) const {
+    return a <= b && b <= subtree_ends[a];
+  }
+  // the least class both a and b conform to, in O(log depth)
+  ClassId join(ClassId a, ClassId b) const;
+
+  SelectorId selector(Symbol name);        // numbering it if new
+  SelectorId find_selector(Symbol name) const;  // -1 if not numbered
+  int num_selectors() const { return selector_names.size(); }
+
+private:
+  std::vector<Class_> declared;
+  std::vector<Class_> classes;             // by ClassId
+  std::vector<ClassId> subtree_ends;
+  // ancestors[k][c] is the 2^k-th ancestor of c, or Object if the chain
+  // is shorter
+  std::vector<std::vector<ClassId>> ancestors;
+  std::vector<ClassId> class_ids;          // by idtable index
+  std::vector<Symbol> selector_names;      // by SelectorId
+  std::vector<SelectorId> selector_ids;    // by idtable index
+};
+
+// The methods of every class, laid out like dispatch tables: a class's
+// table is its parent's, with the methods it redefines replaced in their
+// slots and the ones it adds appended.  A selector keeps its slot in all
+// the classes below the one that introduced it, so the only index needed
+// is the few slots each selector has, shared by all classes.  The code
+// generator emits its dispatch tables from the same layout.
+class MethodLayout {
+public:
+  struct Entry {
+    Symbol owner;                  // the class defining the method
+    method_class const* method;
+    SelectorId selector;           // its name's
+  };
+
+  // Classes must be added parents first (as in ClassId order).
+  void add_class(ClassRegistry& registry, ClassId c);
+  std::vector<Entry> const& table(ClassId c) const { return tables[c]; }
+  // the slot of the selector in the class's table, -1 if it has no such
+  // method
+  int slot(ClassId c, SelectorId selector) const;
+private:
+  std::vector<std::vector<Entry>> tables;             // by ClassId
+  std::vector<std::vector<int>> selector_slots;       // by SelectorId
+  int slot(std::vector<Entry> const& table, SelectorId selector) const;
+};
 
 // This is a structure that may be used to contain the semantic
 // information such as the inheritance graph.  You may use it or not as
@@ -32,30 +105,43 @@ public:
   std::unordered_map<Symbol, std::vector<Symbol>> graph;
   std::unordered_map<Symbol, Class_> sym_class;
   ostream& error_stream;
-  MethodTable m_Table;
-  void build_method_table(std::unordered_map<Symbol, method_class const*>& methods,
-    Symbol class_node);
-  
-  Symbol lowest_common_ancestor(std::unordered_set<Symbol> const& classes) const;
-  Symbol lowest_common_ancestor(std::unordered_set<Symbol>& classes, Symbol class_node) const;
-  void type_check(ObjectEnv& object_env, Symbol class_node) const;
+  MethodLayout methods;
+  ClassRegistry registry;
+
+  // The least class all n classes conform to; NULL if one of them is not
+  // a class.  O(log depth) per class, and no allocation.
+  Symbol lowest_common_ancestor(Symbol a, Symbol b) const;
+  Symbol lowest_common_ancestor(Symbol const* classes, int n) const;
+  void add_attributes(ObjectEnv& object_env, ClassId c) const;
+  void type_check(ObjectEnv& object_env, std::vector<ClassId>& scopes,
+        ClassId c) const;
   ClassTable(Classes);
   int errors() { return semant_errors; }
-  bool type_compare_inclusive(Symbol base_t, Symbol super_t) const;
-  bool type_compare_exclusive(Symbol base_t, Symbol super_t) const;
-  bool is_valid_overload(method_class const& base_method,
-      method_class const& super_method) const;
-  void check_hierarchy(
-        std::unordered_map<Symbol, method_class const*> methods,
-        std::unordered_set<Symbol> members,
+
+  // Whether a type names a class (SELF_TYPE does not).
+  bool is_class(Symbol t) const { return registry.id(t) >= 0; }
+  bool is_basic_class(ClassId c) const;
+  // Whether type t conforms to type u in class_node, where SELF_TYPE
+  // stands for class_node's self type.  A type that is no class (already
+  // reported as undefined) conforms to everything.
+  bool conforms(Symbol t, Symbol u, Symbol class_node) const;
+  // The least type both a and b conform to in class_node.
+  Symbol join(Symbol a, Symbol b, Symbol class_node) const;
+  // The method class_name dispatches name to; NULL if it has none.
+  method_class const* find_method(Symbol class_name, Symbol name) const;
+
+  void check_features(MethodEnv& methods, ObjectEnv& members,
         Symbol class_node) const;
   void check_hierarchy() const;
+  void check_main() const;
   void build_method_table();
   void add_edge(Symbol class_id, Symbol parent_id);
   void type_check() const;
   ostream& semant_error() const;
-  ostream& semant_error(Class_ c);
-  ostream& semant_error(Symbol filename, tree_node *t);
+  ostream& semant_error(Class_ c) const;
+  ostream& semant_error(Symbol filename, tree_node *t) const;
+  // semant_error at t, in the file of the class named class_node
+  ostream& class_error(Symbol class_node, tree_node *t) const;
 };
 
 
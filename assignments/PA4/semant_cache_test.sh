@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Test of the checker's results cache (make semant-cache-test).  Checks
+# each example program twice with the same cache directory (-C): the
+# second run must take every declared class from the cache, and give the
+# same typed tree and diagnostics as checking without the cache.
+#
+#     semant_cache_test.sh
+#
+examples=../../examples
+tmp=/tmp/semant_cache_test.$$
+failed=0
+
+for f in $examples/*.cl; do
+  name=`basename $f .cl`
+  ./lexer $f | ./parser > $tmp.ast
+  classes=`grep -c '^  _class$' $tmp.ast`
+  ./semant < $tmp.ast > $tmp.fresh 2> $tmp.fresh_err
+  rm -rf $tmp.cache
+  ./semant -C $tmp.cache < $tmp.ast > /dev/null 2>&1
+  ./semant -C $tmp.cache -P json < $tmp.ast > $tmp.cached 2> $tmp.cached_err
+  cached=`sed -n 's/.*"semant_cached": \([0-9]*\).*/\1/p' $tmp.cached_err`
+  sed '/^{"phases"/,$d' $tmp.cached_err > $tmp.cached_diag
+  if [ "$cached" != "$classes" ]; then
+    echo "$name: $cached of $classes classes from the cache"
+    failed=1
+  fi
+  if ! cmp -s $tmp.fresh $tmp.cached; then
+    echo "$name: typed tree differs from the cache"
+    failed=1
+  fi
+  if ! cmp -s $tmp.fresh_err $tmp.cached_diag; then
+    echo "$name: diagnostics differ from the cache"
+    diff $tmp.fresh_err $tmp.cached_diag
+    failed=1
+  fi
+done
+rm -rf $tmp.ast $tmp.fresh $tmp.fresh_err $tmp.cache $tmp.cached \
+  $tmp.cached_err $tmp.cached_diag
+
+if [ $failed = 0 ]; then
+  echo "semant-cache-test: every class from the cache, as checked afresh"
+fi
+exit $failed
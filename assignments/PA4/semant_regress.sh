@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# Regression test for the checker (make semant-regress).  Runs ./semant
+# on each example program, lexed and parsed by ./lexer and ./parser, on
+# one thread and on several (-j), and compares its diagnostics and exit
+# status with those of the reference checker, kept in semant-expected/.
+# The typed trees must not depend on the number of threads either.
+#
+#     semant_regress.sh [threads]
+#
+# To record the expected output of a new example, run the reference
+# checker (../../bin/semant) on it and write its stderr followed by
+# "exit <status>".
+#
+jobs=${1:-8}
+examples=../../examples
+expected=semant-expected
+failed=0
+
+for f in $examples/*.cl; do
+  name=`basename $f .cl`
+  ./lexer $f | ./parser > /tmp/semant_regress.$$.ast
+  for j in 1 $jobs; do
+    ./semant -j $j < /tmp/semant_regress.$$.ast 2> /tmp/semant_regress.$$.out > /tmp/semant_regress.$$.j$j
+    echo "exit $?" >> /tmp/semant_regress.$$.out
+    if ! cmp -s $expected/$name.out /tmp/semant_regress.$$.out; then
+      echo "$name (-j $j): diagnostics differ"
+      diff $expected/$name.out /tmp/semant_regress.$$.out
+      failed=1
+    fi
+  done
+  if ! cmp -s /tmp/semant_regress.$$.j1 /tmp/semant_regress.$$.j$jobs; then
+    echo "$name: typed tree differs with -j $jobs"
+    failed=1
+  fi
+done
+rm -f /tmp/semant_regress.$$.ast /tmp/semant_regress.$$.out
+rm -f /tmp/semant_regress.$$.j1 /tmp/semant_regress.$$.j$jobs
+
+if [ $failed = 0 ]; then
+  echo "semant-regress: all examples as expected"
+fi
+exit $failed
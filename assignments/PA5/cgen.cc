@@ -4,14 +4,6 @@
 // Code generator SKELETON
 //
 // Read the comments carefully. Make sure to
-//    initialize the base class tags in
-//       `CgenClassTable::CgenClassTable'
-//
-//    Add the label for the dispatch tables to
-//       `IntEntry::code_def'
-//       `StringEntry::code_def'
-//       `BoolConst::code_def'
-//
 //    Add code to emit everyting else that is needed
 //       in `CgenClassTable::code'
 //
@@ -22,11 +14,25 @@
 //
 //**************************************************************
 
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <vector>
 #include "cgen.h"
 #include "cgen_gc.h"
+#include "stats.h"
+#include "optimize.h"
+#include "ir.h"
 
 extern void emit_string_constant(ostream& str, char *s);
-extern int cgen_debug;
+extern thread_local int cgen_debug;
+extern thread_local int cgen_optimize;
+extern thread_local char *cgen_skip_passes;
+extern thread_local bool disable_reg_alloc;
+extern thread_local bool cgen_use_ir;
+
+// Where the code generator reports errors (per thread).
+thread_local ostream *cgen_error_stream = &cerr;
 
 //
 // Three symbols from the semantic analyzer (semant.cc) are used.
@@ -40,10 +46,11 @@ extern int cgen_debug;
 //
 // For convenience, a large number of symbols are predefined here.
 // These symbols include the primitive type and method names, as well
-// as fixed names used by the runtime system.
+// as fixed names used by the runtime system.  They are per thread, since
+// each thread may be compiling with string tables of its own.
 //
 //////////////////////////////////////////////////////////////////////
-Symbol 
+thread_local Symbol 
        arg,
        arg2,
        Bool,
@@ -129,15 +136,24 @@ BoolConst truebool(TRUE);
 //
 //*********************************************************
 
-void program_class::cgen(ostream &os) 
+int program_class::cgen(ostream &os) 
 {
   // spim wants comments to start with '#'
   os << "# start of generated code\n";
 
   initialize_constants();
-  CgenClassTable *codegen_classtable = new CgenClassTable(classes,os);
+  if (cgen_optimize) {
+    PassManager passes;
+    if (cgen_skip_passes)
+      passes.disable(cgen_skip_passes);       // checked by the driver
+    passes.run(this);
+    if (cgen_debug)
+      passes.report(cout);
+  }
+  CgenClassTable *codegen_classtable = new CgenClassTable(classes,class_table,os);
 
   os << "\n# end of generated code\n";
+  return codegen_classtable->get_errors();
 }
 
 
@@ -155,26 +171,36 @@ void program_class::cgen(ostream &os)
 //
 //////////////////////////////////////////////////////////////////////////////
 
+//
+// Every instruction starts with its opcode, written by emit_opcode, which
+// counts the instruction for the statistics (-P).
+//
+static ostream& emit_opcode(char *opcode, ostream& s)
+{
+  stat_counters.instructions++;
+  return s << opcode;
+}
+
 static void emit_load(char *dest_reg, int offset, char *source_reg, ostream& s)
 {
-  s << LW << dest_reg << " " << offset * WORD_SIZE << "(" << source_reg << ")" 
+  emit_opcode(LW,s) << dest_reg << " " << offset * WORD_SIZE << "(" << source_reg << ")" 
     << endl;
 }
 
 static void emit_store(char *source_reg, int offset, char *dest_reg, ostream& s)
 {
-  s << SW << source_reg << " " << offset * WORD_SIZE << "(" << dest_reg << ")"
+  emit_opcode(SW,s) << source_reg << " " << offset * WORD_SIZE << "(" << dest_reg << ")"
       << endl;
 }
 
 static void emit_load_imm(char *dest_reg, int val, ostream& s)
-{ s << LI << dest_reg << " " << val << endl; }
+{ emit_opcode(LI,s) << dest_reg << " " << val << endl; }
 
 static void emit_load_address(char *dest_reg, char *address, ostream& s)
-{ s << LA << dest_reg << " " << address << endl; }
+{ emit_opcode(LA,s) << dest_reg << " " << address << endl; }
 
 static void emit_partial_load_address(char *dest_reg, ostream& s)
-{ s << LA << dest_reg << " "; }
+{ emit_opcode(LA,s) << dest_reg << " "; }
 
 static void emit_load_bool(char *dest, const BoolConst& b, ostream& s)
 {
@@ -198,43 +224,43 @@ static void emit_load_int(char *dest, IntEntry *i, ostream& s)
 }
 
 static void emit_move(char *dest_reg, char *source_reg, ostream& s)
-{ s << MOVE << dest_reg << " " << source_reg << endl; }
+{ emit_opcode(MOVE,s) << dest_reg << " " << source_reg << endl; }
 
 static void emit_neg(char *dest, char *src1, ostream& s)
-{ s << NEG << dest << " " << src1 << endl; }
+{ emit_opcode(NEG,s) << dest << " " << src1 << endl; }
 
 static void emit_add(char *dest, char *src1, char *src2, ostream& s)
-{ s << ADD << dest << " " << src1 << " " << src2 << endl; }
+{ emit_opcode(ADD,s) << dest << " " << src1 << " " << src2 << endl; }
 
 static void emit_addu(char *dest, char *src1, char *src2, ostream& s)
-{ s << ADDU << dest << " " << src1 << " " << src2 << endl; }
+{ emit_opcode(ADDU,s) << dest << " " << src1 << " " << src2 << endl; }
 
 static void emit_addiu(char *dest, char *src1, int imm, ostream& s)
-{ s << ADDIU << dest << " " << src1 << " " << imm << endl; }
+{ emit_opcode(ADDIU,s) << dest << " " << src1 << " " << imm << endl; }
 
 static void emit_div(char *dest, char *src1, char *src2, ostream& s)
-{ s << DIV << dest << " " << src1 << " " << src2 << endl; }
+{ emit_opcode(DIV,s) << dest << " " << src1 << " " << src2 << endl; }
 
 static void emit_mul(char *dest, char *src1, char *src2, ostream& s)
-{ s << MUL << dest << " " << src1 << " " << src2 << endl; }
+{ emit_opcode(MUL,s) << dest << " " << src1 << " " << src2 << endl; }
 
 static void emit_sub(char *dest, char *src1, char *src2, ostream& s)
-{ s << SUB << dest << " " << src1 << " " << src2 << endl; }
+{ emit_opcode(SUB,s) << dest << " " << src1 << " " << src2 << endl; }
 
 static void emit_sll(char *dest, char *src1, int num, ostream& s)
-{ s << SLL << dest << " " << src1 << " " << num << endl; }
+{ emit_opcode(SLL,s) << dest << " " << src1 << " " << num << endl; }
 
 static void emit_jalr(char *dest, ostream& s)
-{ s << JALR << "\t" << dest << endl; }
+{ emit_opcode(JALR,s) << "\t" << dest << endl; }
 
 static void emit_jal(char *address,ostream &s)
-{ s << JAL << address << endl; }
+{ emit_opcode(JAL,s) << address << endl; }
 
 static void emit_return(ostream& s)
-{ s << RET << endl; }
+{ emit_opcode(RET,s) << endl; }
 
 static void emit_gc_assign(ostream& s)
-{ s << JAL << "_GenGC_Assign" << endl; }
+{ emit_opcode(JAL,s) << "_GenGC_Assign" << endl; }
 
 static void emit_disptable_ref(Symbol sym, ostream& s)
 {  s << sym << DISPTAB_SUFFIX; }
@@ -259,56 +285,56 @@ static void emit_label_def(int l, ostream &s)
 
 static void emit_beqz(char *source, int label, ostream &s)
 {
-  s << BEQZ << source << " ";
+  emit_opcode(BEQZ,s) << source << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_beq(char *src1, char *src2, int label, ostream &s)
 {
-  s << BEQ << src1 << " " << src2 << " ";
+  emit_opcode(BEQ,s) << src1 << " " << src2 << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_bne(char *src1, char *src2, int label, ostream &s)
 {
-  s << BNE << src1 << " " << src2 << " ";
+  emit_opcode(BNE,s) << src1 << " " << src2 << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_bleq(char *src1, char *src2, int label, ostream &s)
 {
-  s << BLEQ << src1 << " " << src2 << " ";
+  emit_opcode(BLEQ,s) << src1 << " " << src2 << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_blt(char *src1, char *src2, int label, ostream &s)
 {
-  s << BLT << src1 << " " << src2 << " ";
+  emit_opcode(BLT,s) << src1 << " " << src2 << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_blti(char *src1, int imm, int label, ostream &s)
 {
-  s << BLT << src1 << " " << imm << " ";
+  emit_opcode(BLT,s) << src1 << " " << imm << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_bgti(char *src1, int imm, int label, ostream &s)
 {
-  s << BGT << src1 << " " << imm << " ";
+  emit_opcode(BGT,s) << src1 << " " << imm << " ";
   emit_label_ref(label,s);
   s << endl;
 }
 
 static void emit_branch(int l, ostream& s)
 {
-  s << BRANCH;
+  emit_opcode(BRANCH,s);
   emit_label_ref(l,s);
   s << endl;
 }
@@ -343,7 +369,7 @@ static void emit_test_collector(ostream &s)
   emit_push(ACC, s);
   emit_move(ACC, SP, s); // stack end
   emit_move(A1, ZERO, s); // allocate nothing
-  s << JAL << gc_collect_names[cgen_Memmgr] << endl;
+  emit_opcode(JAL,s) << gc_collect_names[cgen_Memmgr] << endl;
   emit_addiu(SP,SP,4,s);
   emit_load(ACC,0,SP,s);
 }
@@ -351,7 +377,7 @@ static void emit_test_collector(ostream &s)
 static void emit_gc_check(char *source, ostream &s)
 {
   if (source != (char*)A1) emit_move(A1, source, s);
-  s << JAL << "_gc_check" << endl;
+  emit_opcode(JAL,s) << "_gc_check" << endl;
 }
 
 
@@ -386,7 +412,6 @@ void StringEntry::code_ref(ostream& s)
 
 //
 // Emit code for a constant String.
-// You should fill in the code naming the dispatch table.
 //
 
 void StringEntry::code_def(ostream& s, int stringclasstag)
@@ -400,11 +425,7 @@ void StringEntry::code_def(ostream& s, int stringclasstag)
       << WORD << stringclasstag << endl                                 // tag
       << WORD << (DEFAULT_OBJFIELDS + STRING_SLOTS + (len+4)/4) << endl // size
       << WORD;
-
-
- /***** Add dispatch information for class String ******/
-
-      s << endl;                                              // dispatch table
+      emit_disptable_ref(Str,s);  s << endl;                  // dispatch table
       s << WORD;  lensym->code_ref(s);  s << endl;            // string length
   emit_string_constant(s,str);                                // ascii string
   s << ALIGN;                                                 // align to word
@@ -417,8 +438,8 @@ void StringEntry::code_def(ostream& s, int stringclasstag)
 //
 void StrTable::code_string_table(ostream& s, int stringclasstag)
 {  
-  for (List<StringEntry> *l = tbl; l; l = l->tl())
-    l->hd()->code_def(s,stringclasstag);
+  for (int i = index - 1; i >= 0; i--)
+    tbl[i]->code_def(s,stringclasstag);
 }
 
 //
@@ -431,7 +452,6 @@ void IntEntry::code_ref(ostream &s)
 
 //
 // Emit code for a constant Integer.
-// You should fill in the code naming the dispatch table.
 //
 
 void IntEntry::code_def(ostream &s, int intclasstag)
@@ -443,10 +463,7 @@ void IntEntry::code_def(ostream &s, int intclasstag)
       << WORD << intclasstag << endl                      // class tag
       << WORD << (DEFAULT_OBJFIELDS + INT_SLOTS) << endl  // object size
       << WORD; 
-
- /***** Add dispatch information for class Int ******/
-
-      s << endl;                                          // dispatch table
+      emit_disptable_ref(Int,s);  s << endl;              // dispatch table
       s << WORD << str << endl;                           // integer value
 }
 
@@ -458,8 +475,8 @@ void IntEntry::code_def(ostream &s, int intclasstag)
 //
 void IntTable::code_string_table(ostream &s, int intclasstag)
 {
-  for (List<IntEntry> *l = tbl; l; l = l->tl())
-    l->hd()->code_def(s,intclasstag);
+  for (int i = index - 1; i >= 0; i--)
+    tbl[i]->code_def(s,intclasstag);
 }
 
 
@@ -475,7 +492,6 @@ void BoolConst::code_ref(ostream& s) const
   
 //
 // Emit code for a constant Bool.
-// You should fill in the code naming the dispatch table.
 //
 
 void BoolConst::code_def(ostream& s, int boolclasstag)
@@ -487,10 +503,7 @@ void BoolConst::code_def(ostream& s, int boolclasstag)
       << WORD << boolclasstag << endl                       // class tag
       << WORD << (DEFAULT_OBJFIELDS + BOOL_SLOTS) << endl   // object size
       << WORD;
-
- /***** Add dispatch information for class Bool ******/
-
-      s << endl;                                            // dispatch table
+      emit_disptable_ref(Bool,s);  s << endl;               // dispatch table
       s << WORD << val << endl;                             // value (0 or 1)
 }
 
@@ -617,17 +630,111 @@ void CgenClassTable::code_constants()
 }
 
 
-CgenClassTable::CgenClassTable(Classes classes, ostream& s) : nds(NULL) , str(s)
+//
+// A dispatch table for each class, in tag order: the address of the code
+// for each of its methods, in the slots of the method layout.
+//
+void CgenClassTable::code_dispatch_tables()
 {
-   stringclasstag = 0 /* Change to your String class tag here */;
-   intclasstag =    0 /* Change to your Int class tag here */;
-   boolclasstag =   0 /* Change to your Bool class tag here */;
+  for (ClassId c = 0; c < registry->size(); c++) {
+    const std::vector<MethodLayout::Entry>& table = methods->table(c);
+    emit_disptable_ref(registry->name(c), str);  str << LABEL;
+    for (size_t j = 0; j < table.size(); j++) {
+      str << WORD;
+      emit_method_ref(table[j].owner, table[j].method->get_name(), str);
+      str << endl;
+    }
+  }
+}
 
+//
+// The name of each class (class_nameTab), and its prototype object and
+// init method (class_objTab), by tag.  new SELF_TYPE finds the last two
+// there from the tag of self.
+//
+void CgenClassTable::code_class_tables()
+{
+  str << CLASSNAMETAB << LABEL;
+  for (ClassId c = 0; c < registry->size(); c++) {
+    str << WORD;
+    stringtable.lookup_string(registry->name(c)->get_string())->code_ref(str);
+    str << endl;
+  }
+  str << CLASSOBJTAB << LABEL;
+  for (ClassId c = 0; c < registry->size(); c++) {
+    str << WORD;  emit_protobj_ref(registry->name(c), str);  str << endl;
+    str << WORD;  emit_init_ref(registry->name(c), str);  str << endl;
+  }
+}
+
+//
+// The default value of an attribute or let variable of the given type:
+// 0, "" or false for the basic classes, void for the others.
+//
+static void emit_default_ref(Symbol type, ostream& s)
+{
+  if (type == Int)
+    inttable.lookup_string("0")->code_ref(s);
+  else if (type == Str)
+    stringtable.lookup_string("")->code_ref(s);
+  else if (type == Bool)
+    falsebool.code_ref(s);
+  else
+    s << EMPTYSLOT;
+}
+
+//
+// The prototype object of each class, which new copies: its attributes
+// hold their defaults.  The runtime's slots (of type _prim_slot) are 0.
+//
+void CgenClassTable::code_prototypes()
+{
+  for (ClassId c = 0; c < registry->size(); c++) {
+    CgenNodeP nd = node(c);
+    const std::vector<attr_class *>& attrs = nd->get_attributes();
+    str << WORD << "-1" << endl;
+    emit_protobj_ref(nd->get_name(), str);  str << LABEL
+        << WORD << c << endl
+        << WORD << (DEFAULT_OBJFIELDS + attrs.size()) << endl
+        << WORD;  emit_disptable_ref(nd->get_name(), str);  str << endl;
+    for (attr_class *a : attrs) {
+      str << WORD;
+      emit_default_ref(a->type_decl, str);
+      str << endl;
+    }
+  }
+}
+
+
+CgenClassTable::CgenClassTable(Classes classes, ClassTable *semant_classes,
+                               ostream& s)
+  : str(s), labels(0), dispatches(0), devirtualized(0), errors(0)
+{
    enterscope();
    if (cgen_debug) cout << "Building CgenClassTable" << endl;
+   if (semant_classes) {
+     registry = &semant_classes->registry;
+     methods = &semant_classes->methods;
+   } else {
+     registry = &own_registry;
+     methods = &own_methods;
+   }
    install_basic_classes();
    install_classes(classes);
+   if (own_layout()) {
+     number_classes();
+     build_method_layout();
+   }
    build_inheritance_tree();
+   layout_attributes();
+   if (cgen_optimize) {
+     slot_targets.resize(registry->size());
+     find_slot_targets(root());
+   }
+
+   stringclasstag = probe(Str)->get_tag();
+   intclasstag =    probe(Int)->get_tag();
+   boolclasstag =   probe(Bool)->get_tag();
 
    code();
    exitscope();
@@ -658,6 +765,15 @@ void CgenClassTable::install_basic_classes()
 	new CgenNode(class_(prim_slot,No_class,nil_Features(),filename),
 			    Basic,this));
 
+//
+// semant has the basic classes already.
+//
+  if (!own_layout()) {
+    for (Symbol basic : { Object, IO, Int, Bool, Str })
+      install_class(registry->get_class(registry->id(basic)), Basic);
+    return;
+  }
+
 // 
 // The Object class has no parent class. Its methods are
 //        cool_abort() : Object    aborts the program
@@ -668,7 +784,6 @@ void CgenClassTable::install_basic_classes()
 // are already built in to the runtime system.
 //
   install_class(
-   new CgenNode(
     class_(Object, 
 	   No_class,
 	   append_Features(
@@ -677,7 +792,7 @@ void CgenClassTable::install_basic_classes()
            single_Features(method(type_name, nil_Formals(), Str, no_expr()))),
            single_Features(method(copy, nil_Formals(), SELF_TYPE, no_expr()))),
 	   filename),
-    Basic,this));
+    Basic);
 
 // 
 // The IO class inherits from Object. Its methods are
@@ -687,7 +802,6 @@ void CgenClassTable::install_basic_classes()
 //        in_int() : Int                         "   an int     "  "     "
 //
    install_class(
-    new CgenNode(
      class_(IO, 
             Object,
             append_Features(
@@ -700,27 +814,25 @@ void CgenClassTable::install_basic_classes()
             single_Features(method(in_string, nil_Formals(), Str, no_expr()))),
             single_Features(method(in_int, nil_Formals(), Int, no_expr()))),
 	   filename),	    
-    Basic,this));
+    Basic);
 
 //
 // The Int class has no methods and only a single attribute, the
 // "val" for the integer. 
 //
    install_class(
-    new CgenNode(
      class_(Int, 
 	    Object,
             single_Features(attr(val, prim_slot, no_expr())),
 	    filename),
-     Basic,this));
+     Basic);
 
 //
 // Bool also has only the "val" slot.
 //
     install_class(
-     new CgenNode(
       class_(Bool, Object, single_Features(attr(val, prim_slot, no_expr())),filename),
-      Basic,this));
+      Basic);
 
 //
 // The class Str has a number of slots and operations:
@@ -731,7 +843,6 @@ void CgenClassTable::install_basic_classes()
 //       substr(arg: Int, arg2: Int): Str     substring
 //       
    install_class(
-    new CgenNode(
       class_(Str, 
 	     Object,
              append_Features(
@@ -751,7 +862,7 @@ void CgenClassTable::install_basic_classes()
 				   Str, 
 				   no_expr()))),
 	     filename),
-        Basic,this));
+        Basic);
 
 }
 
@@ -760,9 +871,9 @@ void CgenClassTable::install_basic_classes()
 //
 // install_classes enters a list of classes in the symbol table.
 //
-void CgenClassTable::install_class(CgenNodeP nd)
+void CgenClassTable::install_class(Class_ c, Basicness bstatus)
 {
-  Symbol name = nd->get_name();
+  Symbol name = c->get_name();
 
   if (probe(name))
     {
@@ -771,36 +882,129 @@ void CgenClassTable::install_class(CgenNodeP nd)
 
   // The class name is legal, so add it to the list of classes
   // and the symbol table.
-  nds = new List<CgenNode>(nd,nds);
+  CgenNodeP nd = new CgenNode(c,bstatus,this);
+  installed.push_back(nd);
   addid(name,nd);
+  if (own_layout())
+    registry->add_class(c);
 }
 
 void CgenClassTable::install_classes(Classes cs)
 {
   for(int i = cs->first(); cs->more(i); i = cs->next(i))
-    install_class(new CgenNode(cs->nth(i),NotBasic,this));
+    install_class(cs->nth(i),NotBasic);
+}
+
+//
+// CgenClassTable::number_classes
+//
+// Without semant, the classes are numbered here the way semant numbers
+// them: in a preorder walk of the inheritance tree from Object,
+// subclasses in the order they were installed.
+//
+void CgenClassTable::number_classes()
+{
+  registry->number();
+}
+
+//
+// CgenClassTable::build_method_layout
+//
+// Lays out the dispatch tables the way semant lays out its method tables.
+//
+void CgenClassTable::build_method_layout()
+{
+  for (ClassId c = 0; c < registry->size(); c++)
+    methods->add_class(*registry, c);
 }
 
 //
 // CgenClassTable::build_inheritance_tree
 //
+// The class tags are the ClassIds: the tags of a class and its
+// descendants form the range [tag, max_tag], so an object conforms to a
+// class exactly when its tag is in that range.  The parents come from
+// the numbering too; a class's children are listed in ClassId order,
+// which is the order they were installed.
+//
 void CgenClassTable::build_inheritance_tree()
 {
-  for(List<CgenNode> *l = nds; l; l = l->tl())
-      set_relations(l->hd());
+  nodes.assign(registry->size(), NULL);
+  for (CgenNodeP nd : installed) {
+    ClassId c = registry->id(nd->get_name());
+    nodes[c] = nd;
+    nd->set_tags(c, registry->subtree_end(c));
+  }
+  for (ClassId c = registry->size() - 1; c >= 0; c--) {
+    CgenNodeP parent = c == 0 ? probe(No_class) : nodes[registry->parent(c)];
+    nodes[c]->set_parentnd(parent);
+    parent->add_child(nodes[c]);
+  }
 }
 
 //
-// CgenClassTable::set_relations
+// CgenClassTable::layout_attributes
 //
-// Takes a CgenNode and locates its, and its parent's, inheritance nodes
-// via the class table.  Parent and child pointers are added as appropriate.
+// An object's attributes follow its header: those of its class's
+// ancestors first, and each class's in the order it declares them.
 //
-void CgenClassTable::set_relations(CgenNodeP nd)
+void CgenClassTable::layout_attributes()
+{
+  for (ClassId c = 0; c < registry->size(); c++) {
+    CgenNodeP nd = node(c);
+    std::vector<attr_class *> attrs = nd->get_parentnd()->get_attributes();
+    for (Feature f : *nd->get_features())
+      if (attr_class *a = node_cast<attr_class>(f))
+        attrs.push_back(a);
+    nd->set_attributes(attrs);
+  }
+}
+
+int CgenClassTable::dispatch_slot(Symbol class_name, Symbol method_name)
+{
+  return methods->slot(registry->id(class_name),
+                       registry->find_selector(method_name));
+}
+
+Symbol CgenClassTable::method_owner(Symbol class_name, Symbol method_name)
+{
+  ClassId c = registry->id(class_name);
+  return methods->table(c)[dispatch_slot(class_name, method_name)].owner;
+}
+
+//
+// Class hierarchy analysis, bottom up through the children: the slots
+// of nd's table whose method is the same in every class at or below nd
+// hold that method's class, the others NULL.
+//
+void CgenClassTable::find_slot_targets(CgenNodeP nd)
+{
+  ClassId c = registry->id(nd->get_name());
+  const std::vector<MethodLayout::Entry>& table = methods->table(c);
+  std::vector<Symbol> targets(table.size());
+  for (size_t k = 0; k < table.size(); k++)
+    targets[k] = table[k].owner;
+  for (List<CgenNode> *l = nd->get_children(); l != NULL; l = l->tl()) {
+    find_slot_targets(l->hd());
+    const std::vector<Symbol>& below =
+      slot_targets[registry->id(l->hd()->get_name())];
+    for (size_t k = 0; k < targets.size(); k++)
+      if (below[k] != targets[k])
+        targets[k] = NULL;
+  }
+  slot_targets[c] = targets;
+}
+
+Symbol CgenClassTable::dispatch_target(Symbol class_name, Symbol method_name)
 {
-  CgenNode *parent_node = probe(nd->get_parent());
-  nd->set_parentnd(parent_node);
-  parent_node->add_child(nd);
+  dispatches++;
+  if (!cgen_optimize)
+    return NULL;
+  Symbol target = slot_targets[registry->id(class_name)]
+                              [dispatch_slot(class_name, method_name)];
+  if (target != NULL)
+    devirtualized++;
+  return target;
 }
 
 void CgenNode::add_child(CgenNodeP n)
@@ -828,20 +1032,28 @@ void CgenClassTable::code()
   if (cgen_debug) cout << "coding constants" << endl;
   code_constants();
 
-//                 Add your code to emit
-//                   - prototype objects
-//                   - class_nameTab
-//                   - dispatch tables
-//
+  if (cgen_debug) cout << "coding class tables" << endl;
+  code_class_tables();
+
+  if (cgen_debug) cout << "coding dispatch tables" << endl;
+  code_dispatch_tables();
+
+  if (cgen_debug) cout << "coding prototype objects" << endl;
+  code_prototypes();
 
   if (cgen_debug) cout << "coding global text" << endl;
   code_global_text();
 
-//                 Add your code to emit
-//                   - object initializer
-//                   - the class methods
-//                   - etc...
+  if (cgen_debug) cout << "coding init methods" << endl;
+  code_inits();
 
+  if (cgen_debug) cout << "coding methods" << endl;
+  code_methods();
+  if (cgen_optimize && cgen_debug) {
+    peephole.report(cout);
+    cout << "devirtualized " << devirtualized << " of " << dispatches
+         << " dispatches" << endl;
+  }
 }
 
 
@@ -858,77 +1070,657 @@ CgenNodeP CgenClassTable::root()
 ///////////////////////////////////////////////////////////////////////
 
 CgenNode::CgenNode(Class_ nd, Basicness bstatus, CgenClassTableP ct) :
-   class__class((const class__class &) *nd),
+   cls(nd),
    parentnd(NULL),
    children(NULL),
-   basic_status(bstatus)
+   basic_status(bstatus),
+   tag(-1),
+   max_tag(-1)
 { 
-   stringtable.add_string(name->get_string());          // Add class name to string table
+   stringtable.add_string(get_name()->get_string());          // Add class name to string table
 }
 
+//
+// Branch to label unless the class tag in tag_reg is that of this class
+// or of one of its descendants; a typcase branch tests this way.
+//
+void CgenNode::code_tag_test(char *tag_reg, int label, ostream& s)
+{
+  emit_blti(tag_reg, tag, label, s);
+  emit_bgti(tag_reg, max_tag, label, s);
+}
 
-//******************************************************************
+
+void CgenNode::set_attributes(const std::vector<attr_class *>& a)
+{
+  attrs = a;
+  attr_locs.clear();
+  for (size_t i = 0; i < attrs.size(); i++)
+    attr_locs.push_back(VarLoc(VarLoc::Attr, NULL, DEFAULT_OBJFIELDS + i));
+}
+
+
+///////////////////////////////////////////////////////////////////////
 //
-//   Fill in the following methods to produce code for the
-//   appropriate expression.  You may add or remove parameters
-//   as you wish, but if you do, remember to change the parameters
-//   of the declarations in `cool-tree.h'  Sample code for
-//   constant integers, strings, and booleans are provided.
+// Frame and CgenEnv methods: the frames of routines and their
+// temporaries (see cgen.h)
 //
-//*****************************************************************
+///////////////////////////////////////////////////////////////////////
+
+static char *const saved_regs[] = { "$s1", "$s2", "$s3", "$s4", "$s5", "$s6" };
+static char *const scratch_regs[] = { "$t4", "$t5", "$t6", "$t7", "$t8" };
 
-void assign_class::code(ostream &s) {
+CgenEnv::CgenEnv(CgenClassTable& t, CgenNodeP c)
+  : table(t), cls(c), loop_depth(0), numbering(true), position(0),
+    next_temp(0), nformals(0)
+{
+  vars.enterscope();
+  const std::vector<attr_class *>& attrs = cls->get_attributes();
+  for (size_t i = 0; i < attrs.size(); i++)
+    vars.addid(attrs[i]->name, cls->attribute_loc(i));
 }
 
-void static_dispatch_class::code(ostream &s) {
+int CgenEnv::open_temp()
+{
+  if (!numbering)
+    return next_temp++;
+  int t = intervals.size();
+  LiveInterval live = { position++, -1, false, 0, NULL };
+  intervals.push_back(live);
+  locs.push_back(VarLoc(VarLoc::Frame, NULL, 0, t));
+  uses.push_back(0);
+  use(locs[t]);
+  open.push_back(t);
+  return t;
+}
+
+void CgenEnv::close_temp(int t)
+{
+  if (!numbering)
+    return;
+  intervals[t].end = position++;
+  open.erase(std::find(open.begin(), open.end(), t));
 }
 
-void dispatch_class::code(ostream &s) {
+void CgenEnv::bind_temp(Symbol name, int t)
+{
+  vars.addid(name, &locs[t]);
 }
 
-void cond_class::code(ostream &s) {
+//
+// Count a use of a temporary (setting it is one).  A use inside a loop
+// counts twice, as it is likely made more than once.
+//
+void CgenEnv::use(VarLoc& loc)
+{
+  if (numbering && loc.temp >= 0)
+    uses[loc.temp] += loop_depth > 0 ? 2 : 1;
 }
 
-void loop_class::code(ostream &s) {
+void CgenEnv::call()
+{
+  if (!numbering)
+    return;
+  for (int t : open)
+    intervals[t].across_call = true;
+  position++;
 }
 
-void typcase_class::code(ostream &s) {
+//
+// Place the temporaries.  Those without a register share the words of
+// the frame: one spilled temporary takes the word of another that is
+// dead by the time it is set.
+//
+std::vector<VarLoc> Frame::allocate(std::vector<LiveInterval>& intervals,
+                                    int n, const std::vector<bool>& wanted)
+{
+  nformals = n;
+  std::vector<int> which;
+  std::vector<LiveInterval> live;
+  for (size_t t = 0; t < intervals.size(); t++) {
+    intervals[t].reg = NULL;
+    if ((int) t >= nformals || wanted[t]) {
+      which.push_back(t);
+      live.push_back(intervals[t]);
+    }
+  }
+  LinearScan scan(saved_regs, sizeof(saved_regs) / sizeof(char *),
+                  scratch_regs, sizeof(scratch_regs) / sizeof(char *));
+  if (!disable_reg_alloc)
+    scan.allocate(live);
+  saved = scan.saved_used();
+  for (size_t i = 0; i < which.size(); i++)
+    intervals[which[i]].reg = live[i].reg;
+
+  std::vector<VarLoc> locs(intervals.size());
+  std::vector<int> spilled;
+  for (size_t t = nformals; t < intervals.size(); t++)
+    if (intervals[t].reg == NULL)
+      spilled.push_back(t);
+  std::sort(spilled.begin(), spilled.end(), [&](int a, int b) {
+    return intervals[a].start < intervals[b].start;
+  });
+  std::vector<int> slot_end;                 // by word: when it is free
+  for (int t : spilled) {
+    size_t w = 0;
+    while (w < slot_end.size() && slot_end[w] >= intervals[t].start)
+      w++;
+    if (w == slot_end.size())
+      slot_end.push_back(0);
+    slot_end[w] = intervals[t].end;
+    locs[t] = VarLoc(VarLoc::Frame, NULL, w, t);
+  }
+  spills = slot_end.size();
+
+  formal_regs.assign(nformals, NULL);
+  for (int t = 0; t < (int) intervals.size(); t++)
+    if (intervals[t].reg != NULL) {
+      locs[t] = VarLoc(VarLoc::Reg, intervals[t].reg, 0, t);
+      if (t < nformals)
+        formal_regs[t] = intervals[t].reg;
+    } else if (t < nformals)
+      locs[t] = VarLoc(VarLoc::Frame, NULL, words() + nformals - 1 - t, t);
+  return locs;
+}
+
+void Frame::emit_prologue(ostream& s)
+{
+  emit_addiu(SP, SP, -words() * WORD_SIZE, s);
+  emit_store(FP, words(), SP, s);
+  emit_store(SELF, words() - 1, SP, s);
+  emit_store(RA, words() - 2, SP, s);
+  for (size_t i = 0; i < saved.size(); i++)
+    emit_store(saved[i], words() - 3 - i, SP, s);
+  emit_addiu(FP, SP, WORD_SIZE, s);
+  emit_move(SELF, ACC, s);
+  //
+  // The collector scans the frame, which must not hold stale pointers.
+  //
+  if (cgen_Memmgr != GC_NOGC)
+    for (int w = 0; w < spills; w++)
+      emit_store(ZERO, w, FP, s);
+  for (int t = 0; t < nformals; t++)
+    if (formal_regs[t] != NULL)
+      emit_load(formal_regs[t], words() + nformals - 1 - t, FP, s);
 }
 
-void block_class::code(ostream &s) {
+void Frame::emit_epilogue(ostream& s)
+{
+  emit_load(FP, words(), SP, s);
+  emit_load(SELF, words() - 1, SP, s);
+  emit_load(RA, words() - 2, SP, s);
+  for (size_t i = 0; i < saved.size(); i++)
+    emit_load(saved[i], words() - 3 - i, SP, s);
+  emit_addiu(SP, SP, (words() + nformals) * WORD_SIZE, s);
+  emit_return(s);
 }
 
-void let_class::code(ostream &s) {
+//
+// A formal used only once is left in its argument word, where loading
+// it into a register would gain nothing.  Spilling a temporary costs a
+// load or store for each of its uses, less the load of a formal into
+// its register.
+//
+void CgenEnv::allocate()
+{
+  std::vector<bool> wanted;
+  for (size_t t = 0; t < intervals.size(); t++) {
+    // a formal's one setting is its caller's push
+    intervals[t].spill_cost = (int) t < nformals ? uses[t] - 2 : uses[t];
+    wanted.push_back(uses[t] > 2);
+  }
+  std::vector<VarLoc> placed = frame.allocate(intervals, nformals, wanted);
+  for (size_t t = 0; t < placed.size(); t++)
+    locs[t] = placed[t];
 }
 
-void plus_class::code(ostream &s) {
+//
+// The two passes over the body (see cgen.h).  The first one's labels
+// and instructions are not kept.
+//
+template <class F>
+void CgenEnv::code_routine(ostream& s, Formals formals, F body)
+{
+  vars.enterscope();
+  for (int i = formals->first(); formals->more(i); i = formals->next(i))
+    bind_temp(formals->nth(i)->get_name(), open_temp());
+  nformals = formals->len();
+
+  std::ostream nowhere(NULL);
+  int labels = table.labels;
+  long instructions = stat_counters.instructions;
+  long dispatches = table.dispatches, devirtualized = table.devirtualized;
+  body(nowhere, *this);
+  for (int t = 0; t < nformals; t++)
+    close_temp(t);
+  table.labels = labels;
+  stat_counters.instructions = instructions;
+  table.dispatches = dispatches;
+  table.devirtualized = devirtualized;
+  allocate();
+
+  numbering = false;
+  next_temp = nformals;
+  frame.emit_prologue(s);
+  body(s, *this);
+  frame.emit_epilogue(s);
+  vars.exitscope();
 }
 
-void sub_class::code(ostream &s) {
+
+//////////////////////////////////////////////////////////////////////
+//
+// The routines of the classes
+//
+//////////////////////////////////////////////////////////////////////
+
+//
+// Variables: reading one into a register, and setting one to ACC.
+// Setting an attribute tells the generational collector about it.
+//
+static void emit_load_var(char *dest, VarLoc& loc, ostream& s)
+{
+  switch (loc.kind) {
+  case VarLoc::Reg:   emit_move(dest, loc.reg, s); break;
+  case VarLoc::Frame: emit_load(dest, loc.offset, FP, s); break;
+  case VarLoc::Attr:  emit_load(dest, loc.offset, SELF, s); break;
+  }
+}
+
+static void emit_store_var(VarLoc& loc, ostream& s, CgenEnv& env)
+{
+  switch (loc.kind) {
+  case VarLoc::Reg:   emit_move(loc.reg, ACC, s); break;
+  case VarLoc::Frame: emit_store(ACC, loc.offset, FP, s); break;
+  case VarLoc::Attr:
+    emit_store(ACC, loc.offset, SELF, s);
+    if (cgen_Memmgr == GC_GENGC) {
+      emit_addiu(A1, SELF, loc.offset * WORD_SIZE, s);
+      emit_gc_assign(s);
+      env.call();
+    }
+    break;
+  }
+}
+
+//
+// The value of the Int (or Bool) in temporary loc.
+//
+static void emit_fetch_temp_int(char *dest, VarLoc& loc, ostream& s)
+{
+  if (loc.kind == VarLoc::Reg)
+    emit_fetch_int(dest, loc.reg, s);
+  else {
+    emit_load_var(dest, loc, s);
+    emit_fetch_int(dest, dest, s);
+  }
+}
+
+static void emit_load_default(Symbol type, ostream& s)
+{
+  if (type == Int)
+    emit_load_int(ACC, inttable.lookup_string("0"), s);
+  else if (type == Str)
+    emit_load_string(ACC, stringtable.lookup_string(""), s);
+  else if (type == Bool)
+    emit_load_bool(ACC, falsebool, s);
+  else
+    emit_move(ACC, ZERO, s);
+}
+
+//
+// Abort through the runtime's handler if ACC is void; the handler
+// reports the file and line.
+//
+static void emit_void_check(char *handler, int line, ostream& s, CgenEnv& env)
+{
+  int ok = env.table.new_label();
+  emit_bne(ACC, ZERO, ok, s);
+  emit_load_string(ACC,
+      stringtable.lookup_string(env.cls->get_filename()->get_string()), s);
+  emit_load_imm(T1, line, s);
+  emit_jal(handler, s);
+  emit_label_def(ok, s);
 }
 
-void mul_class::code(ostream &s) {
+//
+// Under -O the code of each routine goes to the output through the
+// peephole optimizer, which takes the instructions it removes off the
+// count of those emitted.
+//
+ostream& CgenClassTable::routine_stream(std::ostringstream& buf)
+{
+  if (cgen_optimize)
+    return buf;
+  return str;
+}
+
+void CgenClassTable::end_routine(std::ostringstream& buf)
+{
+  if (cgen_optimize)
+    stat_counters.instructions -= peephole.run(buf.str(), str);
+}
+
+//
+// The init method of each class: it runs its parent's, then sets the
+// attributes the class declares that have initializers, in order, and
+// returns self.
+//
+void CgenClassTable::code_inits()
+{
+  for (ClassId c = 0; c < registry->size(); c++) {
+    CgenNodeP nd = node(c);
+    std::ostringstream buf;
+    ostream& out = routine_stream(buf);
+    emit_init_ref(nd->get_name(), out);  out << LABEL;
+    if (cgen_use_ir)
+      code_ir(lower_init(*this, nd), out);
+    else {
+      CgenEnv env(*this, nd);
+      env.code_routine(out, nil_Formals(), [&](ostream& s, CgenEnv& env) {
+        if (c != 0) {
+          emit_opcode(JAL,s);
+          emit_init_ref(nd->get_parentnd()->get_name(), s);
+          s << endl;
+          env.call();
+        }
+        const std::vector<attr_class *>& attrs = nd->get_attributes();
+        for (size_t i = nd->own_attributes(); i < attrs.size(); i++) {
+          Expression init = attrs[i]->init;
+          if (init->get_kind() == NODE_no_expr)
+            continue;
+          init->code(s, env);
+          emit_store_var(*nd->attribute_loc(i), s, env);
+        }
+        emit_move(ACC, SELF, s);
+      });
+    }
+    end_routine(buf);
+  }
+}
+
+//
+// The methods of the classes the program declares (the basic classes'
+// are in the runtime).
+//
+void CgenClassTable::code_methods()
+{
+  for (ClassId c = 0; c < registry->size(); c++) {
+    CgenNodeP nd = node(c);
+    if (nd->basic())
+      continue;
+    for (Feature f : *nd->get_features()) {
+      method_class *m = node_cast<method_class>(f);
+      if (m == NULL)
+        continue;
+      if (stats_format != STATS_NONE)
+        begin_method(nd->get_name()->get_string(), m->name->get_string());
+      std::ostringstream buf;
+      ostream& out = routine_stream(buf);
+      emit_method_ref(nd->get_name(), m->name, out);  out << LABEL;
+      if (cgen_use_ir)
+        code_ir(lower_method(*this, nd, m), out);
+      else {
+        CgenEnv env(*this, nd);
+        env.code_routine(out, m->formals, [&](ostream& s, CgenEnv& env) {
+          m->expr->code(s, env);
+        });
+      }
+      end_routine(buf);
+      if (stats_format != STATS_NONE)
+        end_method();
+    }
+  }
+}
+
+
+//******************************************************************
+//
+//   The code of each kind of expression.  Each leaves its value in
+//   ACC; the code of a subexpression may change any register but
+//   self, $fp and the temporaries live across it.
+//
+//*****************************************************************
+
+void assign_class::code(ostream &s, CgenEnv& env) {
+  expr->code(s, env);
+  VarLoc *loc = env.vars.lookup(name);
+  env.use(*loc);
+  emit_store_var(*loc, s, env);
 }
 
-void divide_class::code(ostream &s) {
+//
+// The actuals are pushed in order, then the receiver is computed.
+//
+static void code_actuals(Expressions actuals, ostream& s, CgenEnv& env)
+{
+  for (int i = actuals->first(); actuals->more(i); i = actuals->next(i)) {
+    actuals->nth(i)->code(s, env);
+    emit_push(ACC, s);
+  }
+}
+
+void static_dispatch_class::code(ostream &s, CgenEnv& env) {
+  code_actuals(actual, s, env);
+  expr->code(s, env);
+  emit_void_check("_dispatch_abort", get_line_number(), s, env);
+  emit_opcode(JAL,s);
+  emit_method_ref(env.table.method_owner(type_name, name), name, s);
+  s << endl;
+  env.call();
+}
+
+void dispatch_class::code(ostream &s, CgenEnv& env) {
+  code_actuals(actual, s, env);
+  expr->code(s, env);
+  emit_void_check("_dispatch_abort", get_line_number(), s, env);
+  Symbol type = expr->get_type() == SELF_TYPE ? env.cls->get_name()
+                                              : expr->get_type();
+  Symbol owner = env.table.dispatch_target(type, name);
+  if (owner != NULL) {
+    emit_opcode(JAL,s);  emit_method_ref(owner, name, s);  s << endl;
+  } else {
+    emit_load(T1, DISPTABLE_OFFSET, ACC, s);
+    emit_load(T1, env.table.dispatch_slot(type, name), T1, s);
+    emit_jalr(T1, s);
+  }
+  env.call();
+}
+
+void cond_class::code(ostream &s, CgenEnv& env) {
+  int else_label = env.table.new_label();
+  int end_label = env.table.new_label();
+  pred->code(s, env);
+  emit_fetch_int(T1, ACC, s);
+  emit_beqz(T1, else_label, s);
+  then_exp->code(s, env);
+  emit_branch(end_label, s);
+  emit_label_def(else_label, s);
+  else_exp->code(s, env);
+  emit_label_def(end_label, s);
+}
+
+void loop_class::code(ostream &s, CgenEnv& env) {
+  int top = env.table.new_label();
+  int end = env.table.new_label();
+  env.loop_depth++;
+  emit_label_def(top, s);
+  pred->code(s, env);
+  emit_fetch_int(T1, ACC, s);
+  emit_beqz(T1, end, s);
+  body->code(s, env);
+  emit_branch(top, s);
+  env.loop_depth--;
+  emit_label_def(end, s);
+  emit_move(ACC, ZERO, s);
+}
+
+//
+// The branches are tried from the highest tag down, so the first one
+// whose class the object conforms to is the closest ancestor of its
+// class.
+//
+void typcase_class::code(ostream &s, CgenEnv& env) {
+  expr->code(s, env);
+  emit_void_check("_case_abort2", get_line_number(), s, env);
+
+  std::vector<branch_class *> branches;
+  for (int i = cases->first(); cases->more(i); i = cases->next(i))
+    branches.push_back(node_cast<branch_class>(cases->nth(i)));
+  std::stable_sort(branches.begin(), branches.end(),
+                   [&](branch_class *a, branch_class *b) {
+    return env.table.probe(a->type_decl)->get_tag() >
+           env.table.probe(b->type_decl)->get_tag();
+  });
+
+  int end = env.table.new_label();
+  emit_load(T2, TAG_OFFSET, ACC, s);
+  for (branch_class *b : branches) {
+    int next = env.table.new_label();
+    env.table.probe(b->type_decl)->code_tag_test(T2, next, s);
+    int t = env.open_temp();
+    emit_store_var(env.temp_loc(t), s, env);
+    env.vars.enterscope();
+    env.bind_temp(b->name, t);
+    b->expr->code(s, env);
+    env.vars.exitscope();
+    env.close_temp(t);
+    emit_branch(end, s);
+    emit_label_def(next, s);
+  }
+  emit_jal("_case_abort", s);
+  emit_label_def(end, s);
+}
+
+void block_class::code(ostream &s, CgenEnv& env) {
+  for (int i = body->first(); body->more(i); i = body->next(i))
+    body->nth(i)->code(s, env);
+}
+
+void let_class::code(ostream &s, CgenEnv& env) {
+  if (init->get_kind() == NODE_no_expr)
+    emit_load_default(type_decl, s);
+  else
+    init->code(s, env);
+  int t = env.open_temp();
+  emit_store_var(env.temp_loc(t), s, env);
+  env.vars.enterscope();
+  env.bind_temp(identifier, t);
+  body->code(s, env);
+  env.vars.exitscope();
+  env.close_temp(t);
+}
+
+//
+// e1 op e2 on Ints: e1's value is held in a temporary while e2 is
+// computed, and the result is a copy of e2's Int with the new value.
+//
+static void code_arith(Expression e1, Expression e2,
+                       void (*emit_op)(char *, char *, char *, ostream&),
+                       ostream& s, CgenEnv& env)
+{
+  e1->code(s, env);
+  int t = env.open_temp();
+  emit_store_var(env.temp_loc(t), s, env);
+  e2->code(s, env);
+  emit_jal("Object.copy", s);
+  env.call();
+  emit_fetch_int(T2, ACC, s);
+  env.use(env.temp_loc(t));
+  emit_fetch_temp_int(T1, env.temp_loc(t), s);
+  env.close_temp(t);
+  emit_op(T1, T1, T2, s);
+  emit_store_int(T1, ACC, s);
 }
 
-void neg_class::code(ostream &s) {
+void plus_class::code(ostream &s, CgenEnv& env) {
+  code_arith(e1, e2, emit_add, s, env);
 }
 
-void lt_class::code(ostream &s) {
+void sub_class::code(ostream &s, CgenEnv& env) {
+  code_arith(e1, e2, emit_sub, s, env);
 }
 
-void eq_class::code(ostream &s) {
+void mul_class::code(ostream &s, CgenEnv& env) {
+  code_arith(e1, e2, emit_mul, s, env);
 }
 
-void leq_class::code(ostream &s) {
+void divide_class::code(ostream &s, CgenEnv& env) {
+  code_arith(e1, e2, emit_div, s, env);
 }
 
-void comp_class::code(ostream &s) {
+void neg_class::code(ostream &s, CgenEnv& env) {
+  e1->code(s, env);
+  emit_jal("Object.copy", s);
+  env.call();
+  emit_fetch_int(T1, ACC, s);
+  emit_neg(T1, T1, s);
+  emit_store_int(T1, ACC, s);
 }
 
-void int_const_class::code(ostream& s)  
+//
+// e1 < e2 and e1 <= e2.
+//
+static void code_compare(Expression e1, Expression e2,
+                         void (*emit_branch_if)(char *, char *, int, ostream&),
+                         ostream& s, CgenEnv& env)
+{
+  e1->code(s, env);
+  int t = env.open_temp();
+  emit_store_var(env.temp_loc(t), s, env);
+  e2->code(s, env);
+  emit_fetch_int(T2, ACC, s);
+  env.use(env.temp_loc(t));
+  emit_fetch_temp_int(T1, env.temp_loc(t), s);
+  env.close_temp(t);
+  int done = env.table.new_label();
+  emit_load_bool(ACC, truebool, s);
+  emit_branch_if(T1, T2, done, s);
+  emit_load_bool(ACC, falsebool, s);
+  emit_label_def(done, s);
+}
+
+void lt_class::code(ostream &s, CgenEnv& env) {
+  code_compare(e1, e2, emit_blt, s, env);
+}
+
+//
+// Equal objects are the same one, or Ints, Strings or Bools with the
+// same value, which the runtime's equality_test compares.
+//
+void eq_class::code(ostream &s, CgenEnv& env) {
+  e1->code(s, env);
+  int t = env.open_temp();
+  emit_store_var(env.temp_loc(t), s, env);
+  e2->code(s, env);
+  emit_move(T2, ACC, s);
+  env.use(env.temp_loc(t));
+  emit_load_var(T1, env.temp_loc(t), s);
+  env.close_temp(t);
+  int done = env.table.new_label();
+  emit_load_bool(ACC, truebool, s);
+  emit_beq(T1, T2, done, s);
+  emit_load_bool(A1, falsebool, s);
+  emit_jal("equality_test", s);
+  env.call();
+  emit_label_def(done, s);
+}
+
+void leq_class::code(ostream &s, CgenEnv& env) {
+  code_compare(e1, e2, emit_bleq, s, env);
+}
+
+void comp_class::code(ostream &s, CgenEnv& env) {
+  e1->code(s, env);
+  emit_fetch_int(T1, ACC, s);
+  int done = env.table.new_label();
+  emit_load_bool(ACC, truebool, s);
+  emit_beqz(T1, done, s);
+  emit_load_bool(ACC, falsebool, s);
+  emit_label_def(done, s);
+}
+
+void int_const_class::code(ostream& s, CgenEnv& env)  
 {
   //
   // Need to be sure we have an IntEntry *, not an arbitrary Symbol
@@ -936,26 +1728,430 @@ void int_const_class::code(ostream& s)
   emit_load_int(ACC,inttable.lookup_string(token->get_string()),s);
 }
 
-void string_const_class::code(ostream& s)
+void string_const_class::code(ostream& s, CgenEnv& env)
 {
   emit_load_string(ACC,stringtable.lookup_string(token->get_string()),s);
 }
 
-void bool_const_class::code(ostream& s)
+void bool_const_class::code(ostream& s, CgenEnv& env)
 {
   emit_load_bool(ACC, BoolConst(val), s);
 }
 
-void new__class::code(ostream &s) {
+//
+// new SELF_TYPE takes the prototype and the init method from
+// class_objTab, at twice the tag of self; the second is found again
+// from the tag of the copy, so that nothing need be kept across the
+// call.
+//
+static void emit_class_obj_entry(char *dest, char *obj, ostream& s)
+{
+  emit_load(T2, TAG_OFFSET, obj, s);
+  emit_sll(T2, T2, LOG_WORD_SIZE + 1, s);
+  emit_load_address(T1, CLASSOBJTAB, s);
+  emit_addu(dest, T1, T2, s);
+}
+
+void new__class::code(ostream &s, CgenEnv& env) {
+  if (type_name == SELF_TYPE) {
+    emit_class_obj_entry(T1, SELF, s);
+    emit_load(ACC, 0, T1, s);
+    emit_jal("Object.copy", s);
+    env.call();
+    emit_class_obj_entry(T1, ACC, s);
+    emit_load(T1, 1, T1, s);
+    emit_jalr(T1, s);
+    env.call();
+    return;
+  }
+  emit_partial_load_address(ACC, s);  emit_protobj_ref(type_name, s);  s << endl;
+  emit_jal("Object.copy", s);
+  env.call();
+  emit_opcode(JAL,s);  emit_init_ref(type_name, s);  s << endl;
+  env.call();
+}
+
+void isvoid_class::code(ostream &s, CgenEnv& env) {
+  e1->code(s, env);
+  emit_move(T1, ACC, s);
+  int done = env.table.new_label();
+  emit_load_bool(ACC, truebool, s);
+  emit_beqz(T1, done, s);
+  emit_load_bool(ACC, falsebool, s);
+  emit_label_def(done, s);
+}
+
+void no_expr_class::code(ostream &s, CgenEnv& env) {
+}
+
+void object_class::code(ostream &s, CgenEnv& env) {
+  if (name == self) {
+    emit_move(ACC, SELF, s);
+    return;
+  }
+  VarLoc *loc = env.vars.lookup(name);
+  env.use(*loc);
+  emit_load_var(ACC, *loc, s);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// Instruction selection from the IR (-I; see ir.h)
+//
+// The VRegs are temporaries placed by Frame as those of the direct
+// code generator are.  Their live intervals come from the liveness of
+// the blocks, laid out in order: instruction k reads its operands at
+// 3k, makes its call (if any) at 3k + 1 and sets its result at 3k + 2,
+// except that arithmetic reads its left operand after the copy of the
+// right one, at 3k + 2.  So the operands an instruction reads after
+// its call are live across it, and its result never shares a register
+// with an operand it reads then.
+//
+//////////////////////////////////////////////////////////////////////
+
+class IrSelect {
+public:
+  IrSelect(CgenClassTable& t, IrFunction& fn, ostream& str)
+    : table(t), f(fn), s(str) { }
+  void code();
+
+private:
+  CgenClassTable& table;
+  IrFunction& f;
+  ostream& s;
+  Frame frame;
+  std::vector<VarLoc> locs;                  // by VReg
+  std::vector<int> labels;                   // by block
+
+  void allocate();
+  char *read(VReg v, char *scratch);
+  char *target(VReg v);
+  void write(VReg v, char *reg);
+  void void_check(char *handler, int line);
+  void code_inst(const IrInst& i, int next);
+};
+
+static bool same_reg(char *a, char *b)
+{
+  return strcmp(a, b) == 0;
+}
+
+//
+// A use inside a loop counts twice, as for CgenEnv; the blocks of a
+// loop are those that reach a jump back to its head without passing
+// the head.
+//
+void IrSelect::allocate()
+{
+  int n = f.types.size();
+  std::vector<std::vector<bool> > live_in, live_out;
+  f.liveness(live_in, live_out);
+  std::vector<std::vector<int> > pred = f.predecessors();
+
+  std::vector<bool> in_loop(f.blocks.size(), false);
+  for (size_t b = 0; b < f.blocks.size(); b++)
+    for (int h : f.successors(b))
+      if (h <= (int) b) {
+        std::vector<int> work(1, b);
+        in_loop[h] = true;
+        while (!work.empty()) {
+          int x = work.back();
+          work.pop_back();
+          if (in_loop[x] && x != (int) b)
+            continue;
+          in_loop[x] = true;
+          for (int p : pred[x])
+            if (!in_loop[p])
+              work.push_back(p);
+        }
+      }
+
+  std::vector<LiveInterval> intervals(n);
+  std::vector<int> uses(n, 0);
+  for (LiveInterval& live : intervals)
+    live = LiveInterval{INT_MAX, -1, false, 0, NULL};
+  auto extend = [&](VReg v, int pos) {
+    intervals[v].start = std::min(intervals[v].start, pos);
+    intervals[v].end = std::max(intervals[v].end, pos);
+  };
+  for (int v = 0; v < f.nformals; v++)
+    extend(v, -1);
+
+  std::vector<int> calls;
+  int k = 0;
+  for (size_t b = 0; b < f.blocks.size(); b++) {
+    int first = 3 * k;
+    int weight = in_loop[b] ? 2 : 1;
+    for (const IrInst& i : f.blocks[b].insts) {
+      for (size_t a = 0; a < i.args.size(); a++) {
+        bool late = i.op == IR_ARITH && a == 0;
+        extend(i.args[a], 3 * k + (late ? 2 : 0));
+        uses[i.args[a]] += weight;
+      }
+      if (i.calls())
+        calls.push_back(3 * k + 1);
+      if (i.dest >= 0) {
+        extend(i.dest, 3 * k + 2);
+        uses[i.dest] += weight;
+      }
+      k++;
+    }
+    int last = 3 * k - 1;
+    for (int v = 0; v < n; v++) {
+      if (live_in[b][v])
+        extend(v, first);
+      if (live_out[b][v])
+        extend(v, last);
+    }
+  }
+
+  std::vector<bool> wanted(n);
+  for (int v = 0; v < n; v++) {
+    LiveInterval& live = intervals[v];
+    if (live.end < 0)                         // never set or read
+      live.start = live.end = 0;
+    for (int c : calls)
+      if (live.start < c && c < live.end)
+        live.across_call = true;
+    // a formal is set by its caller's push; a register costs its load
+    live.spill_cost = v < f.nformals ? uses[v] - 1 : uses[v];
+    wanted[v] = uses[v] > 1;
+  }
+  locs = frame.allocate(intervals, f.nformals, wanted);
+}
+
+//
+// The register holding v: its own, or scratch loaded from the frame.
+//
+char *IrSelect::read(VReg v, char *scratch)
+{
+  if (locs[v].kind == VarLoc::Reg)
+    return locs[v].reg;
+  emit_load(scratch, locs[v].offset, FP, s);
+  return scratch;
+}
+
+// the register to compute v in, before write
+char *IrSelect::target(VReg v)
+{
+  if (locs[v].kind == VarLoc::Reg)
+    return locs[v].reg;
+  return ACC;
 }
 
-void isvoid_class::code(ostream &s) {
+void IrSelect::write(VReg v, char *reg)
+{
+  if (locs[v].kind == VarLoc::Reg) {
+    if (!same_reg(reg, locs[v].reg))
+      emit_move(locs[v].reg, reg, s);
+  } else
+    emit_store(reg, locs[v].offset, FP, s);
 }
 
-void no_expr_class::code(ostream &s) {
+void IrSelect::void_check(char *handler, int line)
+{
+  int ok = table.new_label();
+  emit_bne(ACC, ZERO, ok, s);
+  emit_load_string(ACC, stringtable.lookup_string(f.filename->get_string()), s);
+  emit_load_imm(T1, line, s);
+  emit_jal(handler, s);
+  emit_label_def(ok, s);
 }
 
-void object_class::code(ostream &s) {
+void IrSelect::code()
+{
+  allocate();
+  for (size_t b = 0; b < f.blocks.size(); b++)
+    labels.push_back(table.new_label());
+  frame.emit_prologue(s);
+  for (size_t b = 0; b < f.blocks.size(); b++) {
+    if (b > 0)
+      emit_label_def(labels[b], s);
+    for (const IrInst& i : f.blocks[b].insts)
+      code_inst(i, b + 1);
+  }
 }
 
+//
+// The code of instruction i, in the block before block next.
+//
+void IrSelect::code_inst(const IrInst& i, int next)
+{
+  switch (i.op) {
+  case IR_CONST: {
+    char *reg = target(i.dest);
+    if (i.cls == Int)
+      emit_load_int(reg, inttable.lookup_string(i.name->get_string()), s);
+    else if (i.cls == Str)
+      emit_load_string(reg, stringtable.lookup_string(i.name->get_string()), s);
+    else
+      emit_load_bool(reg, i.imm ? truebool : falsebool, s);
+    write(i.dest, reg);
+    break;
+  }
+  case IR_VOID:
+    write(i.dest, ZERO);
+    break;
+  case IR_MOVE:
+    write(i.dest, read(i.args[0], ACC));
+    break;
+  case IR_SELF:
+    write(i.dest, SELF);
+    break;
+  case IR_GETATTR: {
+    char *reg = target(i.dest);
+    emit_load(reg, i.imm, SELF, s);
+    write(i.dest, reg);
+    break;
+  }
+  case IR_SETATTR:
+    emit_store(read(i.args[0], ACC), i.imm, SELF, s);
+    if (cgen_Memmgr == GC_GENGC) {
+      emit_addiu(A1, SELF, i.imm * WORD_SIZE, s);
+      emit_gc_assign(s);
+    }
+    break;
+  case IR_ARITH: {
+    emit_move(ACC, read(i.args[1], ACC), s);
+    emit_jal("Object.copy", s);
+    emit_fetch_int(T2, ACC, s);
+    emit_fetch_int(T1, read(i.args[0], T1), s);
+    switch (i.imm) {
+    case '+': emit_add(T1, T1, T2, s); break;
+    case '-': emit_sub(T1, T1, T2, s); break;
+    case '*': emit_mul(T1, T1, T2, s); break;
+    default:  emit_div(T1, T1, T2, s); break;
+    }
+    emit_store_int(T1, ACC, s);
+    write(i.dest, ACC);
+    break;
+  }
+  case IR_NEG:
+    emit_move(ACC, read(i.args[0], ACC), s);
+    emit_jal("Object.copy", s);
+    emit_fetch_int(T1, ACC, s);
+    emit_neg(T1, T1, s);
+    emit_store_int(T1, ACC, s);
+    write(i.dest, ACC);
+    break;
+  case IR_NOT:
+  case IR_LT:
+  case IR_LEQ:
+  case IR_ISVOID: {
+    // the operands are in $t1 and $t2 before the result is set
+    int done = table.new_label();
+    if (i.op == IR_ISVOID)
+      emit_move(T1, read(i.args[0], T1), s);
+    else
+      emit_fetch_int(T1, read(i.args[0], T1), s);
+    if (i.args.size() > 1)
+      emit_fetch_int(T2, read(i.args[1], T2), s);
+    char *reg = target(i.dest);
+    emit_load_bool(reg, truebool, s);
+    if (i.op == IR_LT)
+      emit_blt(T1, T2, done, s);
+    else if (i.op == IR_LEQ)
+      emit_bleq(T1, T2, done, s);
+    else
+      emit_beqz(T1, done, s);
+    emit_load_bool(reg, falsebool, s);
+    emit_label_def(done, s);
+    write(i.dest, reg);
+    break;
+  }
+  case IR_EQ: {
+    int done = table.new_label();
+    emit_move(T1, read(i.args[0], T1), s);
+    emit_move(T2, read(i.args[1], T2), s);
+    emit_load_bool(ACC, truebool, s);
+    emit_beq(T1, T2, done, s);
+    emit_load_bool(A1, falsebool, s);
+    emit_jal("equality_test", s);
+    emit_label_def(done, s);
+    write(i.dest, ACC);
+    break;
+  }
+  case IR_NEW:
+    emit_partial_load_address(ACC, s);  emit_protobj_ref(i.cls, s);  s << endl;
+    emit_jal("Object.copy", s);
+    emit_opcode(JAL,s);  emit_init_ref(i.cls, s);  s << endl;
+    write(i.dest, ACC);
+    break;
+  case IR_NEW_SELF:
+    emit_class_obj_entry(T1, SELF, s);
+    emit_load(ACC, 0, T1, s);
+    emit_jal("Object.copy", s);
+    emit_class_obj_entry(T1, ACC, s);
+    emit_load(T1, 1, T1, s);
+    emit_jalr(T1, s);
+    write(i.dest, ACC);
+    break;
+  case IR_CALL:
+    for (size_t a = 1; a < i.args.size(); a++)
+      emit_push(read(i.args[a], ACC), s);
+    emit_move(ACC, read(i.args[0], ACC), s);
+    void_check("_dispatch_abort", i.imm);
+    if (i.is_static || table.dispatch_target(i.cls, i.name) != NULL) {
+      emit_opcode(JAL,s);
+      emit_method_ref(table.method_owner(i.cls, i.name), i.name, s);
+      s << endl;
+    } else {
+      emit_load(T1, DISPTABLE_OFFSET, ACC, s);
+      emit_load(T1, table.dispatch_slot(i.cls, i.name), T1, s);
+      emit_jalr(T1, s);
+    }
+    write(i.dest, ACC);
+    break;
+  case IR_INIT:
+    emit_move(ACC, SELF, s);
+    emit_opcode(JAL,s);  emit_init_ref(i.cls, s);  s << endl;
+    break;
+  case IR_JUMP:
+    if (i.targets[0] != next)
+      emit_branch(labels[i.targets[0]], s);
+    break;
+  case IR_BRANCH:
+    emit_fetch_int(T1, read(i.args[0], T1), s);
+    emit_beqz(T1, labels[i.targets[1]], s);
+    if (i.targets[0] != next)
+      emit_branch(labels[i.targets[0]], s);
+    break;
+  case IR_TYPECASE:
+    emit_move(ACC, read(i.args[0], ACC), s);
+    void_check("_case_abort2", i.imm);
+    emit_load(T2, TAG_OFFSET, ACC, s);
+    for (const IrCase& c : i.cases) {
+      int skip = table.new_label();
+      emit_blti(T2, c.tag, skip, s);
+      emit_bgti(T2, c.max_tag, skip, s);
+      emit_branch(labels[c.target], s);
+      emit_label_def(skip, s);
+    }
+    emit_jal("_case_abort", s);
+    break;
+  case IR_RETURN:
+    emit_move(ACC, read(i.args[0], ACC), s);
+    frame.emit_epilogue(s);
+    break;
+  }
+}
 
+//
+// The code of a routine through the IR, after its label.  IR that does
+// not verify is an error, and gets no code.
+//
+void CgenClassTable::code_ir(IrFunction *f, ostream& s)
+{
+  if (!f->verify(*cgen_error_stream)) {
+    *cgen_error_stream << "the IR of " << f->cls << (f->name ? "." : "_init ")
+                       << (f->name ? f->name->get_string() : "") << " is malformed" << endl;
+    errors++;
+    delete f;
+    return;
+  }
+  if (cgen_debug)
+    f->print(cout);
+  IrSelect(*this, *f, s).code();
+  delete f;
+}
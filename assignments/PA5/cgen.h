@@ -1,8 +1,15 @@
 #include <assert.h>
 #include <stdio.h>
+#include <deque>
+#include <sstream>
 #include "emit.h"
 #include "cool-tree.h"
 #include "symtab.h"
+#include "semant.h"
+#include "regalloc.h"
+#include "peephole.h"
+
+class IrFunction;
 
 enum Basicness     {Basic, NotBasic};
 #define TRUE 1
@@ -16,11 +23,20 @@ typedef CgenNode *CgenNodeP;
 
 class CgenClassTable : public SymbolTable<Symbol,CgenNode> {
 private:
-   List<CgenNode> *nds;
+   std::vector<CgenNodeP> installed;          // in the order installed
+   std::vector<CgenNodeP> nodes;              // by ClassId
    ostream& str;
    int stringclasstag;
    int intclasstag;
    int boolclasstag;
+   // semant's numbering and method layout if it left them, otherwise
+   // the table's own
+   ClassRegistry *registry;                   // ClassIds are the tags
+   MethodLayout *methods;                     // as semant lays them out
+   ClassRegistry own_registry;
+   MethodLayout own_methods;
+   bool own_layout() const { return registry == &own_registry; }
+   CgenNodeP node(ClassId c) { return nodes[c]; }
 
 
 // The following methods emit code for
@@ -31,6 +47,20 @@ private:
    void code_bools(int);
    void code_select_gc();
    void code_constants();
+   void code_dispatch_tables();
+   void code_class_tables();
+   void code_prototypes();
+
+// The code of the classes: their init methods and their methods.
+
+   void code_inits();
+   void code_methods();
+   // a routine through the IR (-I), after its label
+   void code_ir(IrFunction *f, ostream& s);
+   // where the code of a routine goes, and the end of it
+   ostream& routine_stream(std::ostringstream& buf);
+   void end_routine(std::ostringstream& buf);
+   Peephole peephole;                         // under -O
 
 // The following creates an inheritance graph from
 // a list of classes.  The graph is implemented as
@@ -38,34 +68,185 @@ private:
 // in the base class symbol table.
 
    void install_basic_classes();
-   void install_class(CgenNodeP nd);
+   void install_class(Class_ c, Basicness bstatus);
    void install_classes(Classes cs);
+   void number_classes();
+   void build_method_layout();
    void build_inheritance_tree();
-   void set_relations(CgenNodeP nd);
+   void layout_attributes();
+
+   int labels;                                // the last label used
+   // dispatches coded, and those made direct calls (-O)
+   long dispatches, devirtualized;
+   int errors;                                // reported to cgen_error_stream
+   // by ClassId and slot, the class whose method a dispatch through the
+   // slot always reaches, or NULL (-O; see dispatch_target)
+   std::vector<std::vector<Symbol> > slot_targets;
+   void find_slot_targets(CgenNodeP nd);
+   friend class CgenEnv;
 public:
-   CgenClassTable(Classes, ostream& str);
+   // semant_classes is semant's table for the classes, or NULL
+   CgenClassTable(Classes, ClassTable *semant_classes, ostream& str);
    void code();
    CgenNodeP root();
+   int get_errors() { return errors; }
+
+   int new_label() { return ++labels; }
+   // the slot of the method in the class's dispatch table, and the
+   // class whose method is in it
+   int dispatch_slot(Symbol class_name, Symbol method_name);
+   Symbol method_owner(Symbol class_name, Symbol method_name);
+   // Under -O, the class whose method a dispatch through class_name's
+   // dispatch table always reaches, or NULL if it may reach others:
+   // the call may then be direct.  Counts the dispatch.
+   Symbol dispatch_target(Symbol class_name, Symbol method_name);
+};
+
+//
+// Where the code keeps a variable: in a register, in a word of the
+// frame ($fp + offset) or in an attribute of self ($s0 + offset).
+// Offsets are in words.
+//
+struct VarLoc {
+   enum Kind { Reg, Frame, Attr };
+   Kind kind;
+   char *reg;
+   int offset;
+   int temp;                                  // the temporary; -1 if none
+
+   VarLoc(Kind k = Frame, char *r = NULL, int o = 0, int t = -1)
+     : kind(k), reg(r), offset(o), temp(t) { }
+};
+
+//
+// The frame of a routine, from $fp up: the spilled temporaries, the
+// callee-saved registers it uses, $ra, the caller's $s0 and $fp, and
+// then the arguments, the last one first.  $fp stays put while the
+// routine pushes arguments for its calls; the routine pops its own
+// arguments when it returns.
+//
+// allocate places the temporaries of the routine, given their live
+// intervals (the formals' first) with their spill costs: linear scan
+// gives them registers, and the others share the words of the frame.
+// A formal not wanted in a register stays in its argument word.
+//
+class Frame {
+public:
+   Frame() : nformals(0), spills(0) { }
+
+   std::vector<VarLoc> allocate(std::vector<LiveInterval>& intervals,
+                                int nformals, const std::vector<bool>& wanted);
+   void emit_prologue(ostream& s);
+   void emit_epilogue(ostream& s);
+
+private:
+   int nformals;
+   std::vector<char *> saved;                 // callee-saved, to restore
+   std::vector<char *> formal_regs;           // NULL for those left in place
+   int spills;
+
+   int words() { return 3 + saved.size() + spills; }
 };
 
+//
+// The state of generating one routine: a method, or the init method of
+// a class (whose body is the initializers of its attributes).
+//
+// The body is generated twice.  The first pass writes nothing: it
+// numbers the positions of the code and records where each temporary
+// is set and last used and which temporaries are live across a call.
+// The temporaries are the formals, the variables of lets and case
+// branches and the left operands of arithmetic and comparisons, so
+// every value the code holds while it computes another is one.  Linear
+// scan then gives them registers, and the second pass emits the code
+// with them.
+//
+// A temporary live across a call gets one of $s1-$s6, which the
+// callee saves; the others get one of $t4-$t8 if one is free.  The rest
+// are spilled to words of the frame (formals stay in the argument
+// words their caller pushed).  All temporaries hold object pointers,
+// and the collector only runs inside calls, where the only live ones
+// are in $s0-$s6 (its roots: MemMgr_REG_MASK) or in the frame (whose
+// words it scans, and which are cleared on entry when it runs).  With
+// -r (disable_reg_alloc) every temporary is spilled.
+//
+class CgenEnv {
+public:
+   CgenEnv(CgenClassTable& table, CgenNodeP cls);
+
+   CgenClassTable& table;
+   CgenNodeP cls;                             // the class of self
+   SymbolTable<Symbol, VarLoc> vars;          // its attributes and locals
 
-class CgenNode : public class__class {
+   int open_temp();                           // set here
+   void close_temp(int t);                    // last used here
+   void bind_temp(Symbol name, int t);        // in the current scope
+   VarLoc& temp_loc(int t) { return locs[t]; }
+   void use(VarLoc& loc);                     // a variable is read or set
+   void call();                               // a call is made here
+   int loop_depth;                            // of the code being emitted
+
+   // the routine, with the body emitted by body(s, env)
+   template <class F> void code_routine(ostream& s, Formals formals, F body);
+
+private:
+   bool numbering;                            // the first pass
+   int position;
+   int next_temp;                             // in the second pass
+   std::vector<LiveInterval> intervals;       // by temporary
+   std::deque<VarLoc> locs;
+   std::vector<int> open;                     // live temporaries
+   std::vector<int> uses;                     // by temporary
+   int nformals;
+   Frame frame;
+
+   void allocate();
+};
+
+
+//
+// The code generator's view of a class: the class itself (the tree
+// semant checked and annotated, not a copy of it) and what code
+// generation keeps about it.
+//
+class CgenNode {
 private: 
+   Class_ cls;
    CgenNodeP parentnd;                        // Parent of class
    List<CgenNode> *children;                  // Children of class
    Basicness basic_status;                    // `Basic' if class is basic
                                               // `NotBasic' otherwise
+   int tag;                                   // preorder number from Object
+   int max_tag;                               // largest tag of a descendant
+   std::vector<attr_class *> attrs;           // inherited ones first
+   std::vector<VarLoc> attr_locs;             // where each one is
 
 public:
    CgenNode(Class_ c,
             Basicness bstatus,
             CgenClassTableP class_table);
 
+   Class_ get_class() { return cls; }
+   Symbol get_name() { return cls->get_name(); }
+   Symbol get_parent_name() { return cls->get_parent_name(); }
+   Features get_features() { return cls->get_features(); }
+   Symbol get_filename() { return cls->get_filename(); }
+
    void add_child(CgenNodeP child);
    List<CgenNode> *get_children() { return children; }
    void set_parentnd(CgenNodeP p);
    CgenNodeP get_parentnd() { return parentnd; }
    int basic() { return (basic_status == Basic); }
+   void set_tags(int t, int max) { tag = t; max_tag = max; }
+   int get_tag() { return tag; }
+   int get_max_tag() { return max_tag; }
+   void code_tag_test(char *tag_reg, int label, ostream& s);
+
+   void set_attributes(const std::vector<attr_class *>& a);
+   const std::vector<attr_class *>& get_attributes() { return attrs; }
+   VarLoc *attribute_loc(int i) { return &attr_locs[i]; }
+   // the index of the first attribute it declares itself
+   int own_attributes() { return parentnd->attrs.size(); }
 };
 
 class BoolConst 
@@ -3,7 +3,7 @@
 #include <string.h>
 #include "stringtab.h"
 
-static int ascii = 0;
+static thread_local int ascii = 0;   // in a .ascii directive (per thread)
 
 void ascii_mode(ostream& str)
 {
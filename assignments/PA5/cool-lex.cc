@@ -0,0 +1 @@
+../PA2/cool-lex.cc
\ No newline at end of file
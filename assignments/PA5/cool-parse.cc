@@ -0,0 +1 @@
+../PA3/cool-parse.cc
\ No newline at end of file
@@ -11,12 +11,21 @@
 
 #include "tree.h"
 #include "cool-tree.handcode.h"
+#include "symtab.h"
 
 
 // define the class for phylum
 // define simple phylum - Program
 typedef class Program_class *Program;
 
+// The PA5 symbol table stores `DAT *', so binding to Entry (and to
+// method_class const) gives the same environments the semantic checker
+// uses in PA4.
+class ClassTable;
+class method_class;
+using ObjectEnv = SymbolTable<Symbol, Entry>;
+using MethodEnv = SymbolTable<Symbol, method_class const>;
+
 class Program_class : public tree_node {
 public:
    tree_node *copy()		 { return copy_Program(); }
@@ -130,7 +139,9 @@ class program_class : public Program_class {
 public:
    Classes classes;
 public:
+   enum { KIND = NODE_program };
    program_class(Classes a1) {
+      kind = KIND;
       classes = a1;
    }
    Program copy_Program();
@@ -153,7 +164,9 @@ public:
    Features features;
    Symbol filename;
 public:
+   enum { KIND = NODE_class_ };
    class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+      kind = KIND;
       name = a1;
       parent = a2;
       features = a3;
@@ -179,7 +192,9 @@ public:
    Symbol return_type;
    Expression expr;
 public:
+   enum { KIND = NODE_method };
    method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+      kind = KIND;
       name = a1;
       formals = a2;
       return_type = a3;
@@ -204,7 +219,9 @@ public:
    Symbol type_decl;
    Expression init;
 public:
+   enum { KIND = NODE_attr };
    attr_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
       init = a3;
@@ -227,7 +244,9 @@ public:
    Symbol name;
    Symbol type_decl;
 public:
+   enum { KIND = NODE_formal };
    formal_class(Symbol a1, Symbol a2) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
    }
@@ -250,7 +269,9 @@ public:
    Symbol type_decl;
    Expression expr;
 public:
+   enum { KIND = NODE_branch };
    branch_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = KIND;
       name = a1;
       type_decl = a2;
       expr = a3;
@@ -273,7 +294,9 @@ public:
    Symbol name;
    Expression expr;
 public:
+   enum { KIND = NODE_assign };
    assign_class(Symbol a1, Expression a2) {
+      kind = KIND;
       name = a1;
       expr = a2;
    }
@@ -297,7 +320,9 @@ public:
    Symbol name;
    Expressions actual;
 public:
+   enum { KIND = NODE_static_dispatch };
    static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+      kind = KIND;
       expr = a1;
       type_name = a2;
       name = a3;
@@ -322,7 +347,9 @@ public:
    Symbol name;
    Expressions actual;
 public:
+   enum { KIND = NODE_dispatch };
    dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+      kind = KIND;
       expr = a1;
       name = a2;
       actual = a3;
@@ -346,7 +373,9 @@ public:
    Expression then_exp;
    Expression else_exp;
 public:
+   enum { KIND = NODE_cond };
    cond_class(Expression a1, Expression a2, Expression a3) {
+      kind = KIND;
       pred = a1;
       then_exp = a2;
       else_exp = a3;
@@ -369,7 +398,9 @@ public:
    Expression pred;
    Expression body;
 public:
+   enum { KIND = NODE_loop };
    loop_class(Expression a1, Expression a2) {
+      kind = KIND;
       pred = a1;
       body = a2;
    }
@@ -391,7 +422,9 @@ public:
    Expression expr;
    Cases cases;
 public:
+   enum { KIND = NODE_typcase };
    typcase_class(Expression a1, Cases a2) {
+      kind = KIND;
       expr = a1;
       cases = a2;
    }
@@ -412,7 +445,9 @@ class block_class : public Expression_class {
 public:
    Expressions body;
 public:
+   enum { KIND = NODE_block };
    block_class(Expressions a1) {
+      kind = KIND;
       body = a1;
    }
    Expression copy_Expression();
@@ -435,7 +470,9 @@ public:
    Expression init;
    Expression body;
 public:
+   enum { KIND = NODE_let };
    let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+      kind = KIND;
       identifier = a1;
       type_decl = a2;
       init = a3;
@@ -459,7 +496,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_plus };
    plus_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -481,7 +520,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_sub };
    sub_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -503,7 +544,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_mul };
    mul_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -525,7 +568,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_divide };
    divide_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -546,7 +591,9 @@ class neg_class : public Expression_class {
 public:
    Expression e1;
 public:
+   enum { KIND = NODE_neg };
    neg_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -567,7 +614,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_lt };
    lt_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -589,7 +638,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_eq };
    eq_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -611,7 +662,9 @@ public:
    Expression e1;
    Expression e2;
 public:
+   enum { KIND = NODE_leq };
    leq_class(Expression a1, Expression a2) {
+      kind = KIND;
       e1 = a1;
       e2 = a2;
    }
@@ -632,7 +685,9 @@ class comp_class : public Expression_class {
 public:
    Expression e1;
 public:
+   enum { KIND = NODE_comp };
    comp_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -652,7 +707,9 @@ class int_const_class : public Expression_class {
 public:
    Symbol token;
 public:
+   enum { KIND = NODE_int_const };
    int_const_class(Symbol a1) {
+      kind = KIND;
       token = a1;
    }
    Expression copy_Expression();
@@ -672,7 +729,9 @@ class bool_const_class : public Expression_class {
 public:
    Boolean val;
 public:
+   enum { KIND = NODE_bool_const };
    bool_const_class(Boolean a1) {
+      kind = KIND;
       val = a1;
    }
    Expression copy_Expression();
@@ -692,7 +751,9 @@ class string_const_class : public Expression_class {
 public:
    Symbol token;
 public:
+   enum { KIND = NODE_string_const };
    string_const_class(Symbol a1) {
+      kind = KIND;
       token = a1;
    }
    Expression copy_Expression();
@@ -712,7 +773,9 @@ class new__class : public Expression_class {
 public:
    Symbol type_name;
 public:
+   enum { KIND = NODE_new_ };
    new__class(Symbol a1) {
+      kind = KIND;
       type_name = a1;
    }
    Expression copy_Expression();
@@ -732,7 +795,9 @@ class isvoid_class : public Expression_class {
 public:
    Expression e1;
 public:
+   enum { KIND = NODE_isvoid };
    isvoid_class(Expression a1) {
+      kind = KIND;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -751,7 +816,9 @@ public:
 class no_expr_class : public Expression_class {
 public:
 public:
+   enum { KIND = NODE_no_expr };
    no_expr_class() {
+      kind = KIND;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
@@ -770,7 +837,9 @@ class object_class : public Expression_class {
 public:
    Symbol name;
 public:
+   enum { KIND = NODE_object };
    object_class(Symbol a1) {
+      kind = KIND;
       name = a1;
    }
    Expression copy_Expression();
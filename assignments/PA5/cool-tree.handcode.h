@@ -9,7 +9,7 @@
 #include "cool.h"
 #include "stringtab.h"
 #define yylineno curr_lineno;
-extern int yylineno;
+extern thread_local int yylineno;
 
 inline Boolean copy_Boolean(Boolean b) {return b; }
 inline void assert_Boolean(Boolean) {}
@@ -44,66 +44,147 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+//
+// The kind of each constructor's nodes (tree_node::get_kind), so that
+// passes can switch on a node instead of asking the type information.
+// Lists are NODE_list.
+//
+enum NodeKind {
+  NODE_list = 0,
+  NODE_program, NODE_class_, NODE_method, NODE_attr, NODE_formal,
+  NODE_branch, NODE_assign, NODE_static_dispatch, NODE_dispatch, NODE_cond,
+  NODE_loop, NODE_typcase, NODE_block, NODE_let, NODE_plus, NODE_sub,
+  NODE_mul, NODE_divide, NODE_neg, NODE_lt, NODE_eq, NODE_leq, NODE_comp,
+  NODE_int_const, NODE_bool_const, NODE_string_const, NODE_new_,
+  NODE_isvoid, NODE_no_expr, NODE_object,
+  NODE_KINDS
+};
+
+//
+// n as a T (a constructor's class, e.g. attr_class) if it is one,
+// otherwise NULL.
+//
+template <class T> inline T *node_cast(tree_node *n)
+  { return n != NULL && n->get_kind() == T::KIND ? static_cast<T *>(n) : NULL; }
+template <class T> inline T const *node_cast(tree_node const *n)
+  { return n != NULL && n->get_kind() == T::KIND ? static_cast<T const *>(n) : NULL; }
+
+class AstWriter;
+class ClassTable;
+class CgenEnv;
+
 #define Program_EXTRAS                          \
-virtual void cgen(ostream&) = 0;		\
-virtual void dump_with_types(ostream&, int) = 0; 
+virtual int semant() = 0;  /* the number of errors */ \
+ClassTable *class_table = NULL; /* semant's, if it found no errors */ \
+virtual int cgen(ostream&) = 0;  /* the number of errors */ \
+virtual void dump_with_types(ostream&, int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 
 #define program_EXTRAS                          \
-void cgen(ostream&);     			\
-void dump_with_types(ostream&, int);            
+int semant();     				\
+int cgen(ostream&);     			\
+void dump_with_types(ostream&, int); \
+void dump_binary(AstWriter&);
 
 #define Class__EXTRAS                   \
-virtual Symbol get_name() = 0;  	\
-virtual Symbol get_parent() = 0;    	\
 virtual Symbol get_filename() = 0;      \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0; \
+virtual Symbol get_parent_name() const = 0; \
+virtual Symbol get_name() const = 0; \
+virtual Features get_features() const = 0;
 
 
-#define class__EXTRAS                                  \
-Symbol get_name()   { return name; }		       \
-Symbol get_parent() { return parent; }     	       \
+#define class__EXTRAS                                 \
 Symbol get_filename() { return filename; }             \
-void dump_with_types(ostream&,int);                    
+void dump_with_types(ostream&,int);                    \
+void dump_binary(AstWriter&); \
+Symbol get_parent_name() const { return parent; } \
+Symbol get_name() const { return name; } \
+Features get_features() const { return features; }
 
 
 #define Feature_EXTRAS                                        \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define Feature_SHARED_EXTRAS                                       \
-void dump_with_types(ostream&,int);    
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&);
 
 
 #define Formal_EXTRAS                              \
-virtual void dump_with_types(ostream&,int) = 0;
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0; \
+virtual Symbol get_name() const = 0; \
+virtual Symbol get_type_decl() const = 0;
 
 
 #define formal_EXTRAS                           \
-void dump_with_types(ostream&,int);
+void dump_with_types(ostream&,int); \
+void dump_binary(AstWriter&); \
+Symbol get_name() const { return name; } \
+Symbol get_type_decl() const { return type_decl; }
 
 
 #define Case_EXTRAS                             \
-virtual void dump_with_types(ostream& ,int) = 0;
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define branch_EXTRAS                                   \
-void dump_with_types(ostream& ,int);
+void dump_with_types(ostream& ,int); \
+void dump_binary(AstWriter&);
 
 
 #define Expression_EXTRAS                    \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
-virtual void code(ostream&) = 0; \
+virtual void code(ostream&, CgenEnv&) = 0; \
 virtual void dump_with_types(ostream&,int) = 0;  \
+virtual void dump_binary(AstWriter&) = 0; \
 void dump_type(ostream&, int);               \
-Expression_class() { type = (Symbol) NULL; }
+Expression_class() { type = (Symbol) NULL; } \
+virtual void check_type(Symbol class_node, ObjectEnv& object_env, \
+	ClassTable const& class_tbl) = 0; \
+/* for a binary operator (plus to divide, lt to leq), points a and b at \
+   its operands and returns true; false for the other expressions */ \
+virtual bool binary_operands(Expression *&a, Expression *&b) \
+	{ return false; }
 
 #define Expression_SHARED_EXTRAS           \
-void code(ostream&); 			   \
-void dump_with_types(ostream&,int); 
+void code(ostream&, CgenEnv&);		   \
+void dump_with_types(ostream&,int);  \
+void dump_binary(AstWriter&); \
+void check_type(Symbol class_node, ObjectEnv& object_env,\
+	ClassTable const& class_tbl) ;
+
+#define BINARY_EXTRAS \
+bool binary_operands(Expression *&a, Expression *&b) \
+	{ a = &e1; b = &e2; return true; }
+
+#define plus_EXTRAS BINARY_EXTRAS
+#define sub_EXTRAS BINARY_EXTRAS
+#define mul_EXTRAS BINARY_EXTRAS
+#define divide_EXTRAS BINARY_EXTRAS
+#define lt_EXTRAS BINARY_EXTRAS
+#define eq_EXTRAS BINARY_EXTRAS
+#define leq_EXTRAS BINARY_EXTRAS
+
+#define attr_EXTRAS \
+Symbol get_name() const { return name; } \
+Symbol get_type_decl() const { return type_decl; } \
+Expression get_init() const { return init; }
+
+#define method_EXTRAS \
+Symbol get_name() const { return name; } \
+Symbol get_return_type() const { return return_type; } \
+Formals get_formals() const { return formals; } \
+Expression get_expr() const { return expr; }
 
 
 #endif
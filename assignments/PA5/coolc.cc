@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  coolc.cc
+//
+//  Single-process compiler driver.  Links the lexer (PA2), the parser
+//  (PA3), the semantic checker (PA4) and the code generator into one
+//  binary, so the token stream and the AST are handed from phase to
+//  phase in memory instead of being dumped as text and re-parsed.  The
+//  phases are run by a CompilerContext (libcoolc.h).
+//
+//  Option -v dumps the token stream and option -a dumps the AST after
+//  parsing and after semantic analysis, in the same formats the
+//  stand-alone phases exchange (binary ASTs with -b).  Nothing is dumped
+//  otherwise.
+//
+//  The input files are lexed and parsed in parallel, one file at a time
+//  per thread; option -j sets the number of threads (by default, one per
+//  processor).  The result does not depend on it.
+//
+//  Option -P reports the time and memory taken by each phase (see
+//  stats.h).
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include "cool-io.h"  //includes iostream
+#include "cool-tree.h"
+#include "cool-parse.h"
+#include "utilities.h"
+#include "ast-binary.h"
+#include "libcoolc.h"
+#include "stats.h"
+#include "optimize.h"
+
+extern int optind;            // for option processing
+extern char *out_filename;    // name of output assembly
+extern int lex_verbose;       // dump the token stream
+extern int ast_verbose;       // dump the AST after each phase
+extern int ast_binary;        // ... in binary rather than text
+extern thread_local char *cgen_skip_passes;
+
+extern thread_local FILE *fin;           // the lexer's input
+extern thread_local int curr_lineno;
+extern thread_local char *curr_filename;
+extern thread_local size_t comment_depth;
+
+extern int cool_yylex();
+extern void cool_scan_file(FILE *);
+extern void cool_unmap_file();
+extern void dump_cool_token(ostream& out, int lineno,
+			    int token, YYSTYPE yylval);
+void handle_flags(int argc, char *argv[]);
+
+//
+// Debugging aid (-v): scan all input once, printing the tokens in the
+// format produced by the stand-alone lexer.
+//
+static void dump_tokens(char **files, int num_files)
+{
+  int token;
+
+  for (int i = 0; i < num_files; i++) {
+    bool dumped_filename = false;
+    fin = fopen(files[i], "r");
+    if (fin == NULL) {
+      cerr << "Could not open input file " << files[i] << endl;
+      exit(1);
+    }
+    curr_filename = files[i];
+    curr_lineno = 1;
+    comment_depth = 0;
+    cool_scan_file(fin);
+    while ((token = cool_yylex()) != 0) {
+      if (!dumped_filename) {
+        dumped_filename = true;
+        cout << "#name \"" << curr_filename << "\"" << endl;
+      }
+      dump_cool_token(cout, curr_lineno, token, cool_yylval);
+    }
+  }
+  cool_unmap_file();
+}
+
+static void dump_ast(Program p)
+{
+  if (ast_binary)
+    dump_ast_binary(cout, p);
+  else
+    p->dump_with_types(cout,0);
+}
+
+int main(int argc, char *argv[]) {
+  handle_flags(argc,argv);
+  if (optind >= argc) {
+    cerr << "usage: " << argv[0] << " [options] input-files" << endl;
+    exit(1);
+  }
+  if (cgen_skip_passes && !check_pass_names(cgen_skip_passes, cerr))
+    exit(1);
+  char **input_files = argv + optind;
+  int num_input_files = argc - optind;
+
+  if (!out_filename) {   // no -o option
+    out_filename = new char[strlen(input_files[0])+8];
+    strcpy(out_filename, input_files[0]);
+    char *dot = strrchr(out_filename, '.');
+    if (dot) *dot = '\0'; // strip off file extension
+    strcat(out_filename, ".s");
+  }
+
+  //
+  // This thread works with the compilation's string tables throughout,
+  // so that -v and -P see them.
+  //
+  CompilerContext compiler(CompilerOptions::from_flags());
+  string_tables = compiler.get_string_tables();
+
+  if (lex_verbose) {
+    begin_phase("tokens");
+    dump_tokens(input_files, num_input_files);
+  }
+
+  std::vector<CoolSource> sources;
+  for (int i = 0; i < num_input_files; i++)
+    sources.push_back(CoolSource(input_files[i]));
+  begin_phase("parse");
+  bool parsed = compiler.parse(sources);
+  cerr << compiler.errors();
+  if (!parsed)
+    exit(1);
+  if (ast_verbose) {
+    begin_phase("dump");
+    dump_ast(compiler.get_program());
+  }
+
+  begin_phase("semant");
+  bool checked = compiler.semant();
+  cerr << compiler.errors();
+  if (!checked)
+    exit(1);
+  if (ast_verbose) {
+    begin_phase("dump");
+    dump_ast(compiler.get_program());
+  }
+
+  //
+  // Don't touch the output file until we know that earlier phases of the
+  // compiler have succeeded.
+  //
+  ofstream s(out_filename);
+  if (!s) {
+    cerr << "Cannot open output file " << out_filename << endl;
+    exit(1);
+  }
+  begin_phase("cgen");
+  bool generated = compiler.cgen(s);
+  cerr << compiler.errors();
+  s.close();
+  if (!generated)
+    exit(1);
+  print_stats();
+
+  //
+  // Everything the compilation allocated is released with the context.
+  //
+  return 0;
+}
@@ -0,0 +1,400 @@
+//
+// ir.cc
+//
+// The control flow graph, liveness, printer and verifier of the
+// three-address IR; see ir.h.
+//
+#include <sstream>
+#include "ir.h"
+#include "cgen_gc.h"
+
+extern thread_local Memmgr cgen_Memmgr;
+extern thread_local Symbol Bool, Int;
+
+bool IrInst::calls() const
+{
+  switch (op) {
+  case IR_ARITH: case IR_NEG:                 // Object.copy
+  case IR_EQ:                                 // equality_test
+  case IR_NEW: case IR_NEW_SELF: case IR_CALL: case IR_INIT:
+    return true;
+  case IR_SETATTR:                            // _GenGC_Assign
+    return cgen_Memmgr == GC_GENGC;
+  default:
+    return false;
+  }
+}
+
+IrFunction::IrFunction(Symbol c, Symbol n, Symbol f, int formals)
+  : cls(c), name(n), filename(f), nformals(formals)
+{ }
+
+VReg IrFunction::new_vreg(Symbol type)
+{
+  types.push_back(type);
+  return types.size() - 1;
+}
+
+int IrFunction::new_block()
+{
+  blocks.push_back(IrBlock());
+  return blocks.size() - 1;
+}
+
+std::vector<int> IrFunction::successors(int b) const
+{
+  std::vector<int> succ;
+  if (blocks[b].insts.empty())
+    return succ;
+  const IrInst& last = blocks[b].insts.back();
+  succ = last.targets;
+  for (const IrCase& c : last.cases)
+    succ.push_back(c.target);
+  return succ;
+}
+
+std::vector<std::vector<int> > IrFunction::predecessors() const
+{
+  std::vector<std::vector<int> > pred(blocks.size());
+  for (size_t b = 0; b < blocks.size(); b++)
+    for (int s : successors(b))
+      pred[s].push_back(b);
+  return pred;
+}
+
+//
+// The usual backward dataflow: a VReg is live into a block if the
+// block reads it before setting it, or if it is live out of the block
+// and the block does not set it.
+//
+void IrFunction::liveness(std::vector<std::vector<bool> >& live_in,
+                          std::vector<std::vector<bool> >& live_out) const
+{
+  int n = types.size();
+  live_in.assign(blocks.size(), std::vector<bool>(n, false));
+  live_out.assign(blocks.size(), std::vector<bool>(n, false));
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t b = blocks.size(); b-- > 0; ) {
+      std::vector<bool> live(n, false);
+      for (int s : successors(b))
+        for (int v = 0; v < n; v++)
+          if (live_in[s][v])
+            live[v] = true;
+      if (live != live_out[b]) {
+        live_out[b] = live;
+        changed = true;
+      }
+      const std::vector<IrInst>& insts = blocks[b].insts;
+      for (size_t i = insts.size(); i-- > 0; ) {
+        if (insts[i].dest >= 0)
+          live[insts[i].dest] = false;
+        for (VReg a : insts[i].args)
+          live[a] = true;
+      }
+      if (live != live_in[b]) {
+        live_in[b] = live;
+        changed = true;
+      }
+    }
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// The printer
+//
+//////////////////////////////////////////////////////////////////////
+
+static const char *op_names[] = {
+  "const", "void", "move", "self", "getattr", "setattr", "arith", "neg",
+  "not", "lt", "leq", "eq", "isvoid", "new", "new_self", "call", "init",
+  "jump", "branch", "typecase", "return"
+};
+
+static void print_vreg(ostream& s, VReg v)
+{
+  s << "%" << v;
+}
+
+static void print_inst(ostream& s, const IrFunction& f, const IrInst& i)
+{
+  s << "    ";
+  if (i.dest >= 0) {
+    print_vreg(s, i.dest);
+    s << ":" << f.types[i.dest] << " = ";
+  }
+  switch (i.op) {
+  case IR_CONST:
+    s << "const " << i.cls << " ";
+    if (i.cls == Bool)
+      s << (i.imm ? "true" : "false");
+    else if (i.cls == Int)
+      s << i.name;
+    else
+      s << "\"" << i.name << "\"";
+    break;
+  case IR_ARITH:
+    print_vreg(s, i.args[0]);
+    s << " " << (char) i.imm << " ";
+    print_vreg(s, i.args[1]);
+    break;
+  case IR_GETATTR:
+    s << "getattr " << i.imm;
+    break;
+  case IR_SETATTR:
+    s << "setattr " << i.imm << ", ";
+    print_vreg(s, i.args[0]);
+    break;
+  case IR_NEW:
+  case IR_INIT:
+    s << op_names[i.op] << " " << i.cls;
+    break;
+  case IR_CALL:
+    s << "call ";
+    print_vreg(s, i.args[0]);
+    s << (i.is_static ? "@" : ".") << i.cls << "." << i.name << "(";
+    for (size_t a = 1; a < i.args.size(); a++) {
+      if (a > 1)
+        s << ", ";
+      print_vreg(s, i.args[a]);
+    }
+    s << ") line " << i.imm;
+    break;
+  case IR_JUMP:
+    s << "jump bb" << i.targets[0];
+    break;
+  case IR_BRANCH:
+    s << "branch ";
+    print_vreg(s, i.args[0]);
+    s << ", bb" << i.targets[0] << ", bb" << i.targets[1];
+    break;
+  case IR_TYPECASE:
+    s << "typecase ";
+    print_vreg(s, i.args[0]);
+    for (const IrCase& c : i.cases)
+      s << ", [" << c.tag << "-" << c.max_tag << "] bb" << c.target;
+    s << " line " << i.imm;
+    break;
+  default:
+    s << op_names[i.op];
+    for (size_t a = 0; a < i.args.size(); a++) {
+      s << (a ? ", " : " ");
+      print_vreg(s, i.args[a]);
+    }
+    break;
+  }
+  s << endl;
+}
+
+void IrFunction::print(ostream& s) const
+{
+  s << (name ? "method " : "init ") << cls;
+  if (name)
+    s << "." << name;
+  s << "(";
+  for (int v = 0; v < nformals; v++)
+    s << (v ? ", " : "") << "%" << v << ":" << types[v];
+  s << ")" << endl;
+
+  std::vector<std::vector<int> > pred = predecessors();
+  for (size_t b = 0; b < blocks.size(); b++) {
+    s << "  bb" << b << ":";
+    if (!pred[b].empty()) {
+      s << "    # from";
+      for (int p : pred[b])
+        s << " bb" << p;
+    }
+    s << endl;
+    for (const IrInst& i : blocks[b].insts)
+      print_inst(s, *this, i);
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// The verifier
+//
+// Checks that each block ends in its only terminator, that the
+// targets are blocks and the entry block is not one, that each
+// instruction has the operands and result its opcode wants, of the
+// right types where the opcode computes on Ints or Bools, and that
+// every VReg read is set on all the paths that reach the read.
+//
+//////////////////////////////////////////////////////////////////////
+
+// the operands of each opcode (-1 for one or more) and whether it sets
+// a VReg
+static const int op_args[] = {
+  0, 0, 1, 0, 0, 1, 2, 1, 1, 2, 2, 2, 1, 0, 0, -1, 0, 0, 1, 1, 1
+};
+static const bool op_dest[] = {
+  true, true, true, true, true, false, true, true, true, true, true, true,
+  true, true, true, true, false, false, false, false, false
+};
+
+bool IrFunction::verify(ostream& errors) const
+{
+  std::ostringstream why;
+  int nvregs = types.size();
+  auto fail = [&](int b, int i, const char *what) {
+    why << "bb" << b;
+    if (i >= 0)
+      why << " instruction " << i;
+    why << ": " << what << endl;
+  };
+
+  if (blocks.empty())
+    why << "no blocks" << endl;
+  if (nformals > nvregs)
+    why << "fewer VRegs than formals" << endl;
+
+  for (size_t b = 0; b < blocks.size(); b++) {
+    const std::vector<IrInst>& insts = blocks[b].insts;
+    if (insts.empty() || !insts.back().is_terminator())
+      fail(b, -1, "does not end in a terminator");
+    for (size_t n = 0; n < insts.size(); n++) {
+      const IrInst& i = insts[n];
+      if (i.is_terminator() && n + 1 < insts.size())
+        fail(b, n, "terminator before the end of the block");
+      int want = op_args[i.op];
+      if (want >= 0 ? (int) i.args.size() != want : i.args.empty())
+        fail(b, n, "wrong number of operands");
+      if (op_dest[i.op] != (i.dest >= 0))
+        fail(b, n, op_dest[i.op] ? "no result" : "unexpected result");
+      if (i.dest >= nvregs)
+        fail(b, n, "result is not a VReg");
+      bool in_range = true;
+      for (VReg a : i.args)
+        if (a < 0 || a >= nvregs)
+          in_range = false;
+      if (!in_range) {
+        fail(b, n, "operand is not a VReg");
+        continue;
+      }
+      for (int t : i.targets)
+        if (t <= 0 || t >= (int) blocks.size())
+          fail(b, n, "target is not a block other than the entry");
+      for (const IrCase& c : i.cases)
+        if (c.target <= 0 || c.target >= (int) blocks.size())
+          fail(b, n, "target is not a block other than the entry");
+      if ((i.op == IR_JUMP && i.targets.size() != 1) ||
+          (i.op == IR_BRANCH && i.targets.size() != 2))
+        fail(b, n, "wrong number of targets");
+
+      auto type_is = [&](VReg v, Symbol t) {
+        return v >= 0 && v < nvregs && types[v] == t;
+      };
+      switch (i.op) {
+      case IR_CONST:
+        if (!type_is(i.dest, i.cls))
+          fail(b, n, "constant of another type");
+        break;
+      case IR_ARITH:
+      case IR_NEG:
+        for (VReg a : i.args)
+          if (!type_is(a, Int))
+            fail(b, n, "arithmetic on a non-Int");
+        if (!type_is(i.dest, Int))
+          fail(b, n, "arithmetic result not an Int");
+        break;
+      case IR_LT:
+      case IR_LEQ:
+        for (VReg a : i.args)
+          if (!type_is(a, Int))
+            fail(b, n, "comparison of a non-Int");
+        // fall through
+      case IR_EQ:
+      case IR_ISVOID:
+        if (!type_is(i.dest, Bool))
+          fail(b, n, "test result not a Bool");
+        break;
+      case IR_NOT:
+        if (!type_is(i.args[0], Bool) || !type_is(i.dest, Bool))
+          fail(b, n, "not of a non-Bool");
+        break;
+      case IR_BRANCH:
+        if (!type_is(i.args[0], Bool))
+          fail(b, n, "branch on a non-Bool");
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  if (!why.str().empty()) {
+    print(errors);
+    errors << why.str();
+    return false;
+  }
+
+  std::vector<std::vector<int> > pred = predecessors();
+  if (!pred[0].empty())
+    why << "bb0: the entry block is a target" << endl;
+
+  //
+  // The VRegs set on every path into each block: the formals at the
+  // entry, and elsewhere those set on every path out of all of its
+  // predecessors.  Blocks no path reaches do not count.
+  //
+  std::vector<std::vector<bool> > set_in(blocks.size(),
+                                         std::vector<bool>(nvregs, true));
+  std::vector<bool> reached(blocks.size(), false);
+  reached[0] = true;
+  for (int v = 0; v < nvregs; v++)
+    set_in[0][v] = v < nformals;
+  auto set_out = [&](int b) {
+    std::vector<bool> set = set_in[b];
+    for (const IrInst& i : blocks[b].insts)
+      if (i.dest >= 0)
+        set[i.dest] = true;
+    return set;
+  };
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t b = 1; b < blocks.size(); b++) {
+      std::vector<bool> set(nvregs, true);
+      bool any = false;
+      for (int p : pred[b])
+        if (reached[p]) {
+          any = true;
+          std::vector<bool> out = set_out(p);
+          for (int v = 0; v < nvregs; v++)
+            set[v] = set[v] && out[v];
+        }
+      if (any && (!reached[b] || set != set_in[b])) {
+        reached[b] = true;
+        set_in[b] = set;
+        changed = true;
+      }
+    }
+  }
+  for (size_t b = 0; b < blocks.size(); b++) {
+    if (!reached[b])
+      continue;
+    std::vector<bool> set = set_in[b];
+    const std::vector<IrInst>& insts = blocks[b].insts;
+    for (size_t n = 0; n < insts.size(); n++) {
+      for (VReg a : insts[n].args)
+        if (!set[a]) {
+          std::ostringstream what;
+          what << "%" << a << " may be read before it is set";
+          fail(b, n, what.str().c_str());
+        }
+      if (insts[n].dest >= 0)
+        set[insts[n].dest] = true;
+    }
+  }
+
+  if (!why.str().empty()) {
+    print(errors);
+    errors << why.str();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,116 @@
+#ifndef _IR_H_
+#define _IR_H_
+
+//
+// A three-address intermediate representation of the routines of a
+// program, between the typed AST and MIPS (-I).  Each routine (a method,
+// or the init method of a class) is an IrFunction: a control flow graph
+// of basic blocks, each a list of instructions ending in one that
+// transfers control (a terminator).
+//
+// The instructions compute on virtual registers (VRegs), numbered from
+// 0 in each function; the formals are the first ones.  Every VReg holds
+// a Cool object (or void) and has the static type of the values it
+// holds, so Int and Bool values stay boxed as the runtime wants them: the
+// arithmetic instructions make new Int objects, the comparisons give
+// Bool objects.  A VReg may be set more than once (a variable is one
+// VReg), but it must be set on every path before it is read.
+//
+// lower_method and lower_init (ir_lower.cc) build the functions from the
+// tree, and CgenClassTable::code_ir (cgen.cc) selects MIPS instructions
+// for them.  print writes a function out as text, and verify checks
+// that it is well formed.
+//
+#include <vector>
+#include "cool-tree.h"
+
+typedef int VReg;
+
+enum IrOp {
+  IR_CONST,       // dest = constant (cls Int, String or Bool; token, or imm)
+  IR_VOID,        // dest = void
+  IR_MOVE,        // dest = a
+  IR_SELF,        // dest = self
+  IR_GETATTR,     // dest = self.attribute (imm: word offset)
+  IR_SETATTR,     // self.attribute = a (imm: word offset)
+  IR_ARITH,       // dest = a op b (imm: '+', '-', '*' or '/')
+  IR_NEG,         // dest = ~a
+  IR_NOT,         // dest = not a
+  IR_LT,          // dest = a < b
+  IR_LEQ,         // dest = a <= b
+  IR_EQ,          // dest = a = b
+  IR_ISVOID,      // dest = isvoid a
+  IR_NEW,         // dest = new cls
+  IR_NEW_SELF,    // dest = new SELF_TYPE
+  IR_CALL,        // dest = a.name(b, ...), through cls's dispatch table,
+                  // or cls's method itself if is_static; aborts at line
+                  // imm if a is void
+  IR_INIT,        // run cls's init method on self
+
+  // the terminators
+  IR_JUMP,        // to targets[0]
+  IR_BRANCH,      // to targets[0] if a is true, else targets[1]
+  IR_TYPECASE,    // to the target of the first case whose tags a's class
+                  // tag is in; aborts (at line imm if a is void) if none
+  IR_RETURN       // return a
+};
+
+struct IrCase {
+  int tag, max_tag;           // the tags of a class and its descendants
+  int target;
+};
+
+struct IrInst {
+  IrOp op;
+  VReg dest;                  // -1 if none
+  std::vector<VReg> args;     // a, b, ...
+  Symbol cls;
+  Symbol name;                // the method called, or a constant's token
+  bool is_static;
+  int imm;
+  std::vector<int> targets;   // blocks
+  std::vector<IrCase> cases;
+
+  IrInst(IrOp o) : op(o), dest(-1), cls(NULL), name(NULL), is_static(false),
+                   imm(0) { }
+  bool is_terminator() const { return op >= IR_JUMP; }
+  // whether the code for it calls into other code (which may collect)
+  bool calls() const;
+};
+
+struct IrBlock {
+  std::vector<IrInst> insts;
+};
+
+class IrFunction {
+public:
+  IrFunction(Symbol cls, Symbol name, Symbol filename, int nformals);
+
+  Symbol cls;
+  Symbol name;                // NULL for the init method
+  Symbol filename;            // the class's, for the void aborts
+  int nformals;
+  std::vector<Symbol> types;  // by VReg
+  std::vector<IrBlock> blocks;  // blocks[0] is the entry
+
+  VReg new_vreg(Symbol type);
+  int new_block();
+
+  std::vector<int> successors(int b) const;
+  std::vector<std::vector<int> > predecessors() const;
+  // the VRegs live into and out of each block
+  void liveness(std::vector<std::vector<bool> >& live_in,
+                std::vector<std::vector<bool> >& live_out) const;
+
+  void print(ostream& s) const;
+  // Whether the function is well formed; if not, writes why to errors.
+  bool verify(ostream& errors) const;
+};
+
+class CgenClassTable;
+class CgenNode;
+IrFunction *lower_method(CgenClassTable& table, CgenNode *cls,
+                         method_class *method);
+IrFunction *lower_init(CgenClassTable& table, CgenNode *cls);
+
+#endif
@@ -0,0 +1,385 @@
+//
+// ir_lower.cc
+//
+// Lowering the typed tree of a routine to the three-address IR; see
+// ir.h.  Each expression's value is left in a VReg of its own (a read
+// of a variable is a move out of it, so that assigning the variable
+// later does not change the value read), evaluated in the order the
+// code generator evaluates it: the actuals of a dispatch before its
+// receiver, the left operand of an operator before the right one.
+//
+#include <algorithm>
+#include <deque>
+#include "cgen.h"
+#include "ir.h"
+
+extern thread_local Symbol Bool, Int, Object, self, SELF_TYPE, Str;
+
+namespace {
+
+// where a variable is: a VReg, or a word of self
+struct IrVar {
+  bool attr;
+  int index;                  // the VReg, or the word's offset
+};
+
+class Lowering {
+public:
+  Lowering(CgenClassTable& t, CgenNodeP c, IrFunction *f);
+
+  IrFunction *f;
+  SymbolTable<Symbol, IrVar> vars;
+  int current;                // the block being filled
+
+  VReg lower(Expression e);
+  IrVar *bind(Symbol name, VReg v);
+  void add(const IrInst& i) { f->blocks[current].insts.push_back(i); }
+  VReg add(IrOp op, Symbol type, std::vector<VReg> args);
+  void move(VReg dest, VReg a);
+  void jump(int target);
+
+private:
+  CgenClassTable& table;
+  CgenNodeP cls;
+  std::deque<IrVar> locals;
+
+  VReg lower_default(Symbol type);
+  VReg lower_dispatch(Expression receiver, Expressions actuals, Symbol cls,
+                      Symbol name, bool is_static, Expression e);
+  VReg lower_typcase(typcase_class *e);
+};
+
+Lowering::Lowering(CgenClassTable& t, CgenNodeP c, IrFunction *fn)
+  : f(fn), current(fn->new_block()), table(t), cls(c)
+{
+  vars.enterscope();
+  const std::vector<attr_class *>& attrs = cls->get_attributes();
+  for (size_t i = 0; i < attrs.size(); i++) {
+    locals.push_back(IrVar{true, cls->attribute_loc(i)->offset});
+    vars.addid(attrs[i]->name, &locals.back());
+  }
+}
+
+IrVar *Lowering::bind(Symbol name, VReg v)
+{
+  locals.push_back(IrVar{false, v});
+  vars.addid(name, &locals.back());
+  return &locals.back();
+}
+
+VReg Lowering::add(IrOp op, Symbol type, std::vector<VReg> args)
+{
+  IrInst i(op);
+  i.dest = f->new_vreg(type);
+  i.args = args;
+  add(i);
+  return i.dest;
+}
+
+void Lowering::move(VReg dest, VReg a)
+{
+  IrInst i(IR_MOVE);
+  i.dest = dest;
+  i.args.push_back(a);
+  add(i);
+}
+
+void Lowering::jump(int target)
+{
+  IrInst i(IR_JUMP);
+  i.targets.push_back(target);
+  add(i);
+}
+
+//
+// The value of a variable of the type that is not initialized.
+//
+VReg Lowering::lower_default(Symbol type)
+{
+  if (type != Int && type != Str && type != Bool)
+    return add(IR_VOID, type, {});
+  IrInst i(IR_CONST);
+  i.cls = type;
+  if (type == Int)
+    i.name = inttable.lookup_string("0");
+  else if (type == Str)
+    i.name = stringtable.lookup_string("");
+  i.dest = f->new_vreg(type);
+  add(i);
+  return i.dest;
+}
+
+VReg Lowering::lower_dispatch(Expression receiver, Expressions actuals,
+                              Symbol c, Symbol name, bool is_static,
+                              Expression e)
+{
+  IrInst call(IR_CALL);
+  call.args.push_back(-1);
+  for (Expression a : *actuals)
+    call.args.push_back(lower(a));
+  call.args[0] = lower(receiver);
+  call.cls = c == SELF_TYPE ? cls->get_name() : c;
+  call.name = name;
+  call.is_static = is_static;
+  call.imm = e->get_line_number();
+  call.dest = f->new_vreg(e->get_type());
+  add(call);
+  return call.dest;
+}
+
+//
+// The cases are tried from the highest tag down, so the first one
+// whose class the object conforms to is the closest ancestor of its
+// class.
+//
+VReg Lowering::lower_typcase(typcase_class *e)
+{
+  VReg v = lower(e->expr);
+  VReg result = f->new_vreg(e->get_type());
+  int join = f->new_block();
+
+  std::vector<branch_class *> branches;
+  for (Case c : *e->cases)
+    branches.push_back(static_cast<branch_class *>(c));
+  std::stable_sort(branches.begin(), branches.end(),
+                   [&](branch_class *a, branch_class *b) {
+    return table.probe(a->type_decl)->get_tag() >
+           table.probe(b->type_decl)->get_tag();
+  });
+
+  IrInst test(IR_TYPECASE);
+  test.args.push_back(v);
+  test.imm = e->get_line_number();
+  std::vector<int> targets;
+  for (branch_class *b : branches) {
+    CgenNodeP nd = table.probe(b->type_decl);
+    int target = f->new_block();
+    test.cases.push_back(IrCase{nd->get_tag(), nd->get_max_tag(), target});
+    targets.push_back(target);
+  }
+  add(test);
+
+  for (size_t i = 0; i < branches.size(); i++) {
+    current = targets[i];
+    VReg var = f->new_vreg(branches[i]->type_decl);
+    move(var, v);
+    vars.enterscope();
+    bind(branches[i]->name, var);
+    move(result, lower(branches[i]->expr));
+    vars.exitscope();
+    jump(join);
+  }
+  current = join;
+  return result;
+}
+
+VReg Lowering::lower(Expression e)
+{
+  Symbol type = e->get_type();
+  switch (e->get_kind()) {
+  case NODE_int_const:
+  case NODE_string_const:
+  case NODE_bool_const: {
+    IrInst i(IR_CONST);
+    if (e->get_kind() == NODE_int_const) {
+      i.cls = Int;
+      i.name = static_cast<int_const_class *>(e)->token;
+    } else if (e->get_kind() == NODE_string_const) {
+      i.cls = Str;
+      i.name = static_cast<string_const_class *>(e)->token;
+    } else {
+      i.cls = Bool;
+      i.imm = static_cast<bool_const_class *>(e)->val;
+    }
+    i.dest = f->new_vreg(i.cls);
+    add(i);
+    return i.dest;
+  }
+  case NODE_object: {
+    Symbol name = static_cast<object_class *>(e)->name;
+    if (name == self)
+      return add(IR_SELF, SELF_TYPE, {});
+    IrVar *var = vars.lookup(name);
+    if (!var->attr)
+      return add(IR_MOVE, type, {var->index});
+    IrInst i(IR_GETATTR);
+    i.dest = f->new_vreg(type);
+    i.imm = var->index;
+    add(i);
+    return i.dest;
+  }
+  case NODE_assign: {
+    assign_class *t = static_cast<assign_class *>(e);
+    VReg v = lower(t->expr);
+    IrVar *var = vars.lookup(t->name);
+    if (!var->attr)
+      move(var->index, v);
+    else {
+      IrInst i(IR_SETATTR);
+      i.args.push_back(v);
+      i.imm = var->index;
+      add(i);
+    }
+    return v;
+  }
+  case NODE_dispatch: {
+    dispatch_class *t = static_cast<dispatch_class *>(e);
+    return lower_dispatch(t->expr, t->actual, t->expr->get_type(), t->name,
+                          false, e);
+  }
+  case NODE_static_dispatch: {
+    static_dispatch_class *t = static_cast<static_dispatch_class *>(e);
+    return lower_dispatch(t->expr, t->actual, t->type_name, t->name, true, e);
+  }
+  case NODE_cond: {
+    cond_class *t = static_cast<cond_class *>(e);
+    VReg p = lower(t->pred);
+    VReg result = f->new_vreg(type);
+    int then_b = f->new_block(), else_b = f->new_block();
+    int join = f->new_block();
+    IrInst branch(IR_BRANCH);
+    branch.args.push_back(p);
+    branch.targets = {then_b, else_b};
+    add(branch);
+    current = then_b;
+    move(result, lower(t->then_exp));
+    jump(join);
+    current = else_b;
+    move(result, lower(t->else_exp));
+    jump(join);
+    current = join;
+    return result;
+  }
+  case NODE_loop: {
+    loop_class *t = static_cast<loop_class *>(e);
+    int head = f->new_block();
+    jump(head);
+    current = head;
+    VReg p = lower(t->pred);
+    int body = f->new_block(), exit = f->new_block();
+    IrInst branch(IR_BRANCH);
+    branch.args.push_back(p);
+    branch.targets = {body, exit};
+    add(branch);
+    current = body;
+    lower(t->body);
+    jump(head);
+    current = exit;
+    return add(IR_VOID, type, {});
+  }
+  case NODE_typcase:
+    return lower_typcase(static_cast<typcase_class *>(e));
+  case NODE_block: {
+    VReg v = -1;
+    for (Expression b : *static_cast<block_class *>(e)->body)
+      v = lower(b);
+    return v;
+  }
+  case NODE_let: {
+    let_class *t = static_cast<let_class *>(e);
+    VReg init = t->init->get_kind() == NODE_no_expr
+                  ? lower_default(t->type_decl) : lower(t->init);
+    VReg var = f->new_vreg(t->type_decl);
+    move(var, init);
+    vars.enterscope();
+    bind(t->identifier, var);
+    VReg v = lower(t->body);
+    vars.exitscope();
+    return v;
+  }
+  case NODE_plus:
+  case NODE_sub:
+  case NODE_mul:
+  case NODE_divide: {
+    static const char ops[] = { '+', '-', '*', '/' };
+    Expression *e1, *e2;
+    e->binary_operands(e1, e2);
+    VReg a = lower(*e1);
+    VReg b = lower(*e2);
+    IrInst i(IR_ARITH);
+    i.args = {a, b};
+    i.imm = ops[e->get_kind() - NODE_plus];
+    i.dest = f->new_vreg(Int);
+    add(i);
+    return i.dest;
+  }
+  case NODE_lt:
+  case NODE_eq:
+  case NODE_leq: {
+    IrOp op = e->get_kind() == NODE_lt ? IR_LT
+            : e->get_kind() == NODE_eq ? IR_EQ : IR_LEQ;
+    Expression *e1, *e2;
+    e->binary_operands(e1, e2);
+    VReg a = lower(*e1);
+    VReg b = lower(*e2);
+    return add(op, Bool, {a, b});
+  }
+  case NODE_neg:
+    return add(IR_NEG, Int, {lower(static_cast<neg_class *>(e)->e1)});
+  case NODE_comp:
+    return add(IR_NOT, Bool, {lower(static_cast<comp_class *>(e)->e1)});
+  case NODE_isvoid:
+    return add(IR_ISVOID, Bool, {lower(static_cast<isvoid_class *>(e)->e1)});
+  case NODE_new_: {
+    Symbol c = static_cast<new__class *>(e)->type_name;
+    if (c == SELF_TYPE)
+      return add(IR_NEW_SELF, SELF_TYPE, {});
+    IrInst i(IR_NEW);
+    i.cls = c;
+    i.dest = f->new_vreg(type);
+    add(i);
+    return i.dest;
+  }
+  default:                    // no_expr, the body of a loop that never runs
+    return add(IR_VOID, Object, {});
+  }
+}
+
+} // namespace
+
+IrFunction *lower_method(CgenClassTable& table, CgenNodeP cls,
+                         method_class *method)
+{
+  IrFunction *f = new IrFunction(cls->get_name(), method->name,
+                                 cls->get_filename(), method->formals->len());
+  for (Formal formal : *method->formals)
+    f->new_vreg(formal->get_type_decl());
+  Lowering l(table, cls, f);
+  l.vars.enterscope();
+  int v = 0;
+  for (Formal formal : *method->formals)
+    l.bind(formal->get_name(), v++);
+
+  IrInst ret(IR_RETURN);
+  ret.args.push_back(l.lower(method->expr));
+  l.add(ret);
+  return f;
+}
+
+//
+// The init method runs its parent's, then sets the attributes the
+// class declares that have initializers, in order, and returns self.
+//
+IrFunction *lower_init(CgenClassTable& table, CgenNodeP cls)
+{
+  IrFunction *f = new IrFunction(cls->get_name(), NULL, cls->get_filename(), 0);
+  Lowering l(table, cls, f);
+  if (cls->get_name() != Object) {
+    IrInst init(IR_INIT);
+    init.cls = cls->get_parentnd()->get_name();
+    l.add(init);
+  }
+  const std::vector<attr_class *>& attrs = cls->get_attributes();
+  for (size_t i = cls->own_attributes(); i < attrs.size(); i++) {
+    if (attrs[i]->init->get_kind() == NODE_no_expr)
+      continue;
+    IrInst set(IR_SETATTR);
+    set.args.push_back(l.lower(attrs[i]->init));
+    set.imm = cls->attribute_loc(i)->offset;
+    l.add(set);
+  }
+  IrInst ret(IR_RETURN);
+  ret.args.push_back(l.add(IR_SELF, SELF_TYPE, {}));
+  l.add(ret);
+  return f;
+}
@@ -0,0 +1,413 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  libcoolc.cc
+//
+//  The compiler as a library: CompilerContext runs the lexer (PA2), the
+//  parser (PA3), the semantic checker (PA4) and the code generator on
+//  state of its own; see libcoolc.h.
+//
+//  The input files are lexed and parsed in parallel, one file at a time
+//  per thread, on options.jobs threads.  Each file's tree and symbols
+//  are allocated from its own arena and its syntax errors collected
+//  apart; the string tables are shared, and renumbered afterwards in the
+//  order a single thread would have added the strings.  The files'
+//  classes and errors are then merged in order, so the result does not
+//  depend on the number of threads.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "libcoolc.h"
+#include "cool-parse.h"
+#include "semant.h"
+#include "ast-binary.h"
+#include "stats.h"
+#include "optimize.h"
+
+extern int front_end_jobs;    // threads lexing and parsing (-j)
+
+//
+// The flags for semantic analysis and code generation (per thread; see
+// handle_flags.cc).
+//
+extern thread_local int semant_debug;
+extern thread_local int semant_jobs;
+extern thread_local char *semant_cache_dir;
+extern thread_local int cgen_debug;
+extern thread_local int cgen_optimize;
+extern thread_local char *cgen_skip_passes;
+extern thread_local bool disable_reg_alloc;
+extern thread_local bool cgen_use_ir;
+
+//
+// The lexer's, the parser's and the checker's globals are per thread.
+//
+extern thread_local Program ast_root;      // root of the abstract syntax tree
+extern thread_local Classes parse_results; // its classes
+extern thread_local int omerrs;            // a count of lex and parse errors
+extern thread_local int parse_tokens;      // the tokens the parser has read
+extern thread_local ostream *parse_errors; // where they are reported
+extern thread_local ostream *semant_error_stream; // where semant reports
+extern thread_local ostream *cgen_error_stream;   // where cgen reports
+extern thread_local size_t comment_depth;  // nesting depth of the lexer's comments
+extern thread_local int node_lineno;       // line of the next tree node
+
+extern int cool_yylex();
+extern int cool_yyparse();
+extern void cool_scan_file(FILE *);  // maps the file if it can
+extern void cool_scan_string(const char *, int);
+extern void cool_unmap_file();
+
+//
+// The lexer reads from fin and keeps curr_lineno (defined by the parser,
+// which uses it as its location) up to date; the parser stamps
+// curr_filename on every class it builds.
+//
+thread_local FILE *fin;
+extern thread_local int curr_lineno;
+thread_local char *curr_filename = "<stdin>";
+
+//
+// Point the lexer at the beginning of src.  If the file cannot be read,
+// say so and return false.
+//
+static bool open_source(const CoolSource& src)
+{
+  curr_filename = src.name;
+  curr_lineno = 1;
+  comment_depth = 0;
+  if (src.text != NULL) {
+    fin = NULL;
+    cool_scan_string(src.text, src.len);
+    return true;
+  }
+  fin = fopen(src.name, "r");
+  if (fin == NULL) {
+    *parse_errors << "Could not open input file " << src.name << endl;
+    return false;
+  }
+  cool_scan_file(fin);
+  return true;
+}
+
+static void close_source()
+{
+  cool_unmap_file();
+  if (fin != NULL) {
+    fclose(fin);
+    fin = NULL;
+  }
+}
+
+//
+// Called by the flex scanner at end of input.  Each file is scanned on
+// its own, so there is never more input.
+//
+extern "C" int yywrap(void)
+{
+  if (fin != NULL) {
+    fclose(fin);
+    fin = NULL;
+  }
+  return 1;
+}
+
+CompilerOptions::CompilerOptions()
+  : jobs(1), semant_debug(0), semant_cache(NULL), cgen_debug(0),
+    cgen_optimize(0), cgen_skip_passes(NULL), disable_reg_alloc(false),
+    use_ir(false), memmgr(GC_NOGC), memmgr_test(GC_NORMAL),
+    memmgr_debug(GC_QUICK)
+{ }
+
+//
+// The flags of this thread, and setting them.
+//
+static CompilerOptions thread_flags()
+{
+  CompilerOptions o;
+  o.jobs = semant_jobs;
+  o.semant_debug = semant_debug;
+  o.semant_cache = semant_cache_dir;
+  o.cgen_debug = cgen_debug;
+  o.cgen_optimize = cgen_optimize;
+  o.cgen_skip_passes = cgen_skip_passes;
+  o.disable_reg_alloc = disable_reg_alloc;
+  o.use_ir = cgen_use_ir;
+  o.memmgr = cgen_Memmgr;
+  o.memmgr_test = cgen_Memmgr_Test;
+  o.memmgr_debug = cgen_Memmgr_Debug;
+  return o;
+}
+
+static void set_thread_flags(const CompilerOptions& o)
+{
+  semant_jobs = o.jobs;
+  semant_debug = o.semant_debug;
+  semant_cache_dir = o.semant_cache;
+  cgen_debug = o.cgen_debug;
+  cgen_optimize = o.cgen_optimize;
+  cgen_skip_passes = o.cgen_skip_passes;
+  disable_reg_alloc = o.disable_reg_alloc;
+  cgen_use_ir = o.use_ir;
+  cgen_Memmgr = o.memmgr;
+  cgen_Memmgr_Test = o.memmgr_test;
+  cgen_Memmgr_Debug = o.memmgr_debug;
+}
+
+CompilerOptions CompilerOptions::from_flags()
+{
+  CompilerOptions o = thread_flags();
+  o.jobs = front_end_jobs;
+  if (o.jobs <= 0)                // one per processor
+    o.jobs = std::thread::hardware_concurrency();
+  if (o.jobs <= 0)
+    o.jobs = 1;
+  return o;
+}
+
+//
+// What parsing one input file produced.  Its tree nodes and symbols are
+// allocated from its own arena, and its error messages are collected
+// apart, so that files can be parsed on different threads.
+//
+struct ParsedFile {
+  Classes classes;              // NULL if the file has errors or no tokens
+  int line;                     // line of its program node
+  int errors;                   // its omerrs
+  bool empty;                   // it has no tokens
+  std::ostringstream messages;  // what yyerror reported
+  Arena arena;
+};
+
+//
+// While a Scope lives, the thread that made it works for the context:
+// the string tables, the arena, the error streams and the flags are the
+// context's.  The thread's own are put back afterwards.
+//
+class CompilerContext::Scope {
+private:
+  StringTables *old_tables;
+  Arena *old_arena;
+  ostream *old_parse_errors;
+  ostream *old_semant_errors;
+  ostream *old_cgen_errors;
+  CompilerOptions old_flags;
+public:
+  Scope(CompilerContext& c)
+    : old_tables(string_tables), old_arena(compilation_arena),
+      old_parse_errors(parse_errors), old_semant_errors(semant_error_stream),
+      old_cgen_errors(cgen_error_stream), old_flags(thread_flags())
+  {
+    string_tables = &c.tables;
+    compilation_arena = &c.arena;
+    parse_errors = &c.messages;
+    semant_error_stream = &c.messages;
+    cgen_error_stream = &c.messages;
+    set_thread_flags(c.options);
+  }
+
+  ~Scope()
+  {
+    string_tables = old_tables;
+    compilation_arena = old_arena;
+    parse_errors = old_parse_errors;
+    semant_error_stream = old_semant_errors;
+    cgen_error_stream = old_cgen_errors;
+    set_thread_flags(old_flags);
+  }
+};
+
+CompilerContext::CompilerContext(const CompilerOptions& o)
+  : options(o), parsed_files(NULL), ast(NULL)
+{ }
+
+CompilerContext::~CompilerContext()
+{
+  reset();
+}
+
+//
+// Forget the last compilation.  Its symbols point into the arenas, so the
+// tables are cleared before these are released.  semant's class table,
+// kept for cgen, is not in an arena.
+//
+void CompilerContext::reset()
+{
+  if (ast != NULL)
+    delete ast->class_table;
+  tables.ids.clear();
+  tables.ints.clear();
+  tables.strings.clear();
+  delete [] parsed_files;
+  parsed_files = NULL;
+  arena.release();
+  ast = NULL;
+}
+
+//
+// Lex and parse input file i.  The string tables are shared; entries
+// first used here are ordered after those of earlier files by giving
+// each file its own range of intern_order.
+//
+void CompilerContext::parse_file(const std::vector<CoolSource>& sources, int i)
+{
+  ParsedFile& f = parsed_files[i];
+  Arena *old_arena = compilation_arena;
+  ostream *old_errors = parse_errors;
+  compilation_arena = &f.arena;
+  parse_errors = &f.messages;
+  intern_order = (unsigned long) (i + 1) << 32;
+
+  //
+  // A file without tokens (empty, or only comments) is left out.  The
+  // grammar rejects it on its own, so its error is kept apart, for when
+  // every file is empty.
+  //
+  f.classes = NULL;
+  f.errors = 0;
+  f.empty = false;
+  if (!open_source(sources[i]))
+    f.errors = 1;
+  else {
+    omerrs = 0;
+    parse_tokens = 0;
+    cool_yyparse();
+    if (parse_tokens == 0)
+      f.empty = true;
+    else if ((f.errors = omerrs) == 0) {
+      f.classes = parse_results;
+      f.line = ast_root->get_line_number();
+    }
+  }
+  close_source();
+
+  parse_errors = old_errors;
+  compilation_arena = old_arena;
+}
+
+//
+// Parse all the sources on options.jobs threads (the calling thread
+// being one of them), and build the program from their classes in order.
+// Errors are reported in the same order.
+//
+bool CompilerContext::parse(const std::vector<CoolSource>& sources)
+{
+  Scope scope(*this);
+  reset();
+
+  int n = sources.size();
+  if (n == 0) {
+    messages << "No input files\n";
+    return false;
+  }
+  parsed_files = new ParsedFile[n];
+  int jobs = options.jobs < n ? options.jobs : n;
+
+  if (jobs > 1) {
+    tables.ids.begin_concurrent();
+    tables.ints.begin_concurrent();
+    tables.strings.begin_concurrent();
+  }
+  std::atomic<int> next_file(0);
+  auto work = [&]() {
+    string_tables = &tables;
+    for (int i; (i = next_file++) < n; )
+      parse_file(sources, i);
+    merge_counters();
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < jobs; t++)
+    threads.emplace_back(work);
+  work();
+  for (std::thread& t : threads)
+    t.join();
+  if (jobs > 1) {
+    tables.ids.end_concurrent();
+    tables.ints.end_concurrent();
+    tables.strings.end_concurrent();
+  }
+
+  Classes classes = NULL;
+  int errors = 0;
+  for (int i = 0; i < n; i++) {
+    ParsedFile& f = parsed_files[i];
+    if (f.empty)
+      continue;
+    messages << f.messages.str();
+    errors += f.errors;
+    if (f.classes == NULL)
+      continue;
+    if (classes == NULL) {
+      classes = f.classes;
+      node_lineno = f.line;
+    } else
+      classes = append_Classes(classes, f.classes);
+  }
+  if (errors == 0 && classes == NULL) {
+    // No file has any tokens: report the error at the end of the last.
+    messages << parsed_files[n - 1].messages.str();
+    errors = 1;
+  }
+  if (errors != 0) {
+    messages << "Compilation halted due to lex and parse errors\n";
+    return false;
+  }
+  ast = program(classes);
+  return true;
+}
+
+bool CompilerContext::read_ast(FILE *f)
+{
+  Scope scope(*this);
+  reset();
+  ast = read_ast_binary(f, messages);
+  return ast != NULL;
+}
+
+//
+// semant and cgen work on the program of the last successful parse or
+// read_ast; without one there is nothing to check or compile.
+//
+bool CompilerContext::semant()
+{
+  Scope scope(*this);
+  if (ast == NULL) {
+    messages << "No program to check: none has been parsed\n";
+    return false;
+  }
+  return ast->semant() == 0;
+}
+
+bool CompilerContext::cgen(ostream& out)
+{
+  Scope scope(*this);
+  if (ast == NULL) {
+    messages << "No program to compile: none has been parsed or read\n";
+    return false;
+  }
+  if (options.cgen_skip_passes &&
+      !check_pass_names(options.cgen_skip_passes, messages))
+    return false;
+  return ast->cgen(out) == 0;
+}
+
+bool CompilerContext::compile(const std::vector<CoolSource>& sources,
+                              std::string& assembly)
+{
+  if (!parse(sources) || !semant())
+    return false;
+  std::ostringstream s;
+  if (!cgen(s))
+    return false;
+  assembly = s.str();
+  return true;
+}
+
+std::string CompilerContext::errors()
+{
+  std::string e = messages.str();
+  messages.str("");
+  return e;
+}
@@ -0,0 +1,131 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _LIBCOOLC_H_
+#define _LIBCOOLC_H_
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  libcoolc.h
+//
+//  The compiler as a library.  A CompilerContext owns the state of a
+//  compilation: its string tables, the arenas holding its tree and
+//  symbols, its error messages and its options.  Each compilation runs
+//  on the thread that calls the context (plus, while parsing, threads
+//  of its own), so several contexts can compile at the same time on
+//  different threads.  A context can compile one program after another;
+//  each compilation frees what the previous one allocated.
+//
+//  The phases may be run one at a time (coolc does, to dump the AST in
+//  between), or all at once with compile:
+//
+//      CompilerContext c;
+//      std::vector<CoolSource> srcs(1, CoolSource("hello.cl", text, len));
+//      std::string assembly;
+//      if (!c.compile(srcs, assembly))
+//        cerr << c.errors();
+//
+//  A context must not be used by two threads at once.
+//
+//  The lexer's and the parser's debugging switches (yy_flex_debug and
+//  cool_yydebug, set by -l and -p) are shared by all compilations.  The
+//  scanner is generated with them on; handle_flags turns them off, and
+//  a program that does not call it should do the same.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cool-tree.h"
+#include "cgen_gc.h"
+
+//
+// An input file.  Its text is scanned from memory if given; otherwise
+// the file is read (mapped) when it is parsed.
+//
+struct CoolSource {
+  char *name;              // for error messages and the classes' filename
+  const char *text;        // NULL to read the file name
+  int len;
+
+  CoolSource(char *n) : name(n), text(NULL), len(0) { }
+  CoolSource(char *n, const char *t, int l) : name(n), text(t), len(l) { }
+};
+
+//
+// The command line flags that steer a compilation; the defaults are
+// those of handle_flags.
+//
+struct CompilerOptions {
+  int jobs;                       // threads parsing the sources and type
+                                  // checking the classes; 1 for none
+  int semant_debug;
+  char *semant_cache;             // directory semant keeps its results
+                                  // per class in (-C); NULL for none
+  int cgen_debug;
+  int cgen_optimize;
+  char *cgen_skip_passes;         // optimization passes to leave out (-X);
+                                  // NULL for none
+  bool disable_reg_alloc;
+  bool use_ir;                    // generate code through the IR (-I)
+  Memmgr memmgr;
+  Memmgr_Test memmgr_test;
+  Memmgr_Debug memmgr_debug;
+
+  CompilerOptions();
+  static CompilerOptions from_flags(); // as set for this thread by handle_flags
+};
+
+struct ParsedFile;
+
+class CompilerContext {
+private:
+  CompilerOptions options;
+  StringTables tables;
+  Arena arena;                    // all but the parsed files' allocations
+  ParsedFile *parsed_files;       // their trees, in arenas of their own
+  Program ast;                    // NULL until a parse succeeds
+  std::ostringstream messages;    // errors not yet taken by errors()
+
+  class Scope;                    // makes a thread work for the context
+  void reset();
+  void parse_file(const std::vector<CoolSource>& sources, int i);
+
+  CompilerContext(const CompilerContext&);            // not copyable
+  CompilerContext& operator=(const CompilerContext&);
+public:
+  CompilerContext(const CompilerOptions& o = CompilerOptions());
+  ~CompilerContext();
+
+  // The phases, in order.  parse starts a new compilation.  They return
+  // false if they found errors (cgen: in its options or the code); they
+  // are in errors().  semant and cgen fail when there is no program, as
+  // before a parse or after one that failed.
+  bool parse(const std::vector<CoolSource>& sources);
+  bool semant();
+  bool cgen(ostream& out);
+
+  // Start a new compilation with the typed AST in f, in the binary
+  // format (ast-binary.h), in place of parse and semant.  False if it
+  // is malformed.
+  bool read_ast(FILE *f);
+
+  // parse, semant and cgen into assembly
+  bool compile(const std::vector<CoolSource>& sources, std::string& assembly);
+
+  // the tree of the current compilation (after a successful parse)
+  Program get_program() { return ast; }
+
+  // the string tables the current compilation's symbols are in
+  StringTables *get_string_tables() { return &tables; }
+
+  // the error messages reported since the last call
+  std::string errors();
+};
+
+#endif
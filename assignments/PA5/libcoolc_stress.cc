@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  libcoolc_stress.cc
+//
+//  Exercises CompilerContext from several threads at once.  Usage:
+//
+//      libcoolc_stress [-t threads] [-n rounds] files...
+//
+//  Each file is a program of its own: Cool source, which is compiled
+//  from the start, or a typed AST in the binary format (as cgen -a -b
+//  writes it), which is read in place of parsing and checking and
+//  compiled to assembly.  A typed AST must compile without errors.
+//
+//  Reads the files into memory and compiles them once on the main thread
+//  to get the expected assembly (or errors).  Then each of the threads
+//  compiles them all rounds times with a context of its own, reusing it
+//  from round to round; every result must equal the expected one.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "libcoolc.h"
+
+extern int optind;
+extern char *optarg;
+extern int yy_flex_debug;
+
+struct StressProgram {
+  CoolSource source;
+  std::string text;
+  bool typed;                   // a typed AST rather than source
+  std::string expected;
+
+  StressProgram(char *name, const std::string& t)
+    : source(name), text(t), typed(t.compare(0, 4, "\177AST") == 0) { }
+};
+
+static std::vector<StressProgram> programs;
+
+//
+// Whether p compiles to assembly; result is the assembly, or else the
+// errors.
+//
+static bool compile(CompilerContext& c, const StressProgram& p,
+                    std::string& result)
+{
+  bool ok;
+  if (p.typed) {
+    FILE *f = fmemopen((void *) p.text.data(), p.text.size(), "r");
+    std::ostringstream s;
+    ok = c.read_ast(f) && c.cgen(s);
+    fclose(f);
+    result = s.str();
+  } else {
+    std::vector<CoolSource> srcs(1, p.source);
+    srcs[0].text = p.text.data();
+    srcs[0].len = p.text.size();
+    ok = c.compile(srcs, result);
+  }
+  if (!ok)
+    result = c.errors();
+  return ok;
+}
+
+int main(int argc, char *argv[])
+{
+  int threads = 4, rounds = 20;
+  int opt;
+
+  yy_flex_debug = 0;
+  while ((opt = getopt(argc, argv, "t:n:")) != -1) {
+    switch (opt) {
+    case 't': threads = atoi(optarg); break;
+    case 'n': rounds = atoi(optarg); break;
+    default:
+      cerr << "usage: " << argv[0] << " [-t threads] [-n rounds] files...\n";
+      exit(1);
+    }
+  }
+  if (optind >= argc) {
+    cerr << "usage: " << argv[0] << " [-t threads] [-n rounds] files...\n";
+    exit(1);
+  }
+
+  for (int i = optind; i < argc; i++) {
+    std::ifstream f(argv[i]);
+    if (!f) {
+      cerr << "Could not open input file " << argv[i] << endl;
+      exit(1);
+    }
+    std::ostringstream text;
+    text << f.rdbuf();
+    programs.push_back(StressProgram(argv[i], text.str()));
+  }
+
+  int assembled = 0, failed = 0;
+  CompilerContext reference;
+  for (StressProgram& p : programs)
+    if (compile(reference, p, p.expected))
+      assembled++;
+    else if (p.typed) {
+      cerr << p.source.name << ":\n" << p.expected;
+      failed++;
+    }
+
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back([&]() {
+      CompilerContext c;
+      std::string result;
+      for (int r = 0; r < rounds; r++)
+        for (const StressProgram& p : programs) {
+          compile(c, p, result);
+          if (result != p.expected)
+            mismatches++;
+        }
+    });
+  for (std::thread& w : workers)
+    w.join();
+
+  cout << programs.size() << " programs (" << assembled << " to assembly), "
+       << threads << " threads x " << rounds << " rounds: "
+       << mismatches << " mismatches" << endl;
+  return mismatches == 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,525 @@
+//
+// optimize.cc
+//
+// The passes of -O and the manager that runs them; see optimize.h.
+//
+#include <string.h>
+#include <limits.h>
+#include <string>
+#include "optimize.h"
+#include "cool-visitor.h"
+
+extern thread_local Symbol Bool, Int, self;
+
+//
+// Replace each expression just below e with f of it.  The elements of
+// a list are replaced where they are stored, which the other lists on
+// the same buffer (see tree.h) may also see; those are the partial
+// lists the parser built the list from, which nothing keeps.
+//
+template <class F> static void rewrite_children(Expression e, F f)
+{
+  switch (e->get_kind()) {
+  case NODE_assign: {
+    assign_class *t = static_cast<assign_class *>(e);
+    t->expr = f(t->expr);
+    break;
+  }
+  case NODE_static_dispatch: {
+    static_dispatch_class *t = static_cast<static_dispatch_class *>(e);
+    t->expr = f(t->expr);
+    for (Expression& a : *t->actual)
+      a = f(a);
+    break;
+  }
+  case NODE_dispatch: {
+    dispatch_class *t = static_cast<dispatch_class *>(e);
+    t->expr = f(t->expr);
+    for (Expression& a : *t->actual)
+      a = f(a);
+    break;
+  }
+  case NODE_cond: {
+    cond_class *t = static_cast<cond_class *>(e);
+    t->pred = f(t->pred);
+    t->then_exp = f(t->then_exp);
+    t->else_exp = f(t->else_exp);
+    break;
+  }
+  case NODE_loop: {
+    loop_class *t = static_cast<loop_class *>(e);
+    t->pred = f(t->pred);
+    t->body = f(t->body);
+    break;
+  }
+  case NODE_typcase: {
+    typcase_class *t = static_cast<typcase_class *>(e);
+    t->expr = f(t->expr);
+    for (Case c : *t->cases) {
+      branch_class *b = static_cast<branch_class *>(c);
+      b->expr = f(b->expr);
+    }
+    break;
+  }
+  case NODE_block: {
+    block_class *t = static_cast<block_class *>(e);
+    for (Expression& b : *t->body)
+      b = f(b);
+    break;
+  }
+  case NODE_let: {
+    let_class *t = static_cast<let_class *>(e);
+    t->init = f(t->init);
+    t->body = f(t->body);
+    break;
+  }
+  case NODE_plus: case NODE_sub: case NODE_mul: case NODE_divide:
+  case NODE_lt: case NODE_eq: case NODE_leq: {
+    Expression *e1, *e2;
+    e->binary_operands(e1, e2);
+    *e1 = f(*e1);
+    *e2 = f(*e2);
+    break;
+  }
+  case NODE_neg:
+    static_cast<neg_class *>(e)->e1 = f(static_cast<neg_class *>(e)->e1);
+    break;
+  case NODE_comp:
+    static_cast<comp_class *>(e)->e1 = f(static_cast<comp_class *>(e)->e1);
+    break;
+  case NODE_isvoid:
+    static_cast<isvoid_class *>(e)->e1 = f(static_cast<isvoid_class *>(e)->e1);
+    break;
+  default:
+    break;
+  }
+}
+
+//
+// Whether something below e (e included) satisfies pred.
+//
+template <class P> static bool any_node(Expression e, P pred)
+{
+  bool found = false;
+  auto f = [&](tree_node *n) { found = found || pred(n); };
+  walk_tree(e, f);
+  return found;
+}
+
+static bool assigns(Expression e, Symbol name)
+{
+  return any_node(e, [&](tree_node *n) {
+    return n->get_kind() == NODE_assign &&
+           static_cast<assign_class *>(n)->name == name;
+  });
+}
+
+// whether a let or a case branch in e binds name
+static bool binds(Expression e, Symbol name)
+{
+  return any_node(e, [&](tree_node *n) {
+    return (n->get_kind() == NODE_let &&
+            static_cast<let_class *>(n)->identifier == name) ||
+           (n->get_kind() == NODE_branch &&
+            static_cast<branch_class *>(n)->name == name);
+  });
+}
+
+// whether e reads or sets name
+static bool mentions(Expression e, Symbol name)
+{
+  return assigns(e, name) || any_node(e, [&](tree_node *n) {
+    return n->get_kind() == NODE_object &&
+           static_cast<object_class *>(n)->name == name;
+  });
+}
+
+static bool is_constant(Expression e)
+{
+  int k = e->get_kind();
+  return k == NODE_int_const || k == NODE_bool_const || k == NODE_string_const;
+}
+
+static int int_value(Expression e)
+{
+  return atoi(static_cast<int_const_class *>(e)->token->get_string());
+}
+
+static bool bool_value(Expression e)
+{
+  return static_cast<bool_const_class *>(e)->val;
+}
+
+//
+// New constants, with the line of the expression they replace.
+//
+static Expression make_int(int i, Expression old)
+{
+  Expression e = int_const(inttable.add_int(i))->set_type(Int);
+  e->set(old);
+  return e;
+}
+
+static Expression make_bool(bool b, Expression old)
+{
+  Expression e = bool_const(b)->set_type(Bool);
+  e->set(old);
+  return e;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// copies: copy and constant propagation
+//
+// A let variable bound to a constant, or to self or another local (a
+// formal, let or case variable; an attribute may change in any call),
+// is replaced by it where it is used, if neither is assigned in the
+// let's body and the body does not bind the other name again.  The let
+// itself is left for the lets pass.
+//
+//////////////////////////////////////////////////////////////////////
+
+class CopyPass : public OptPass {
+public:
+  CopyPass() : OptPass("copies") { }
+  Expression run(Expression e, Formals formals);
+
+private:
+  // the locals in scope, innermost last, each with what replaces it
+  // (NULL for nothing)
+  std::vector<std::pair<Symbol, Expression> > scope;
+
+  Expression *lookup(Symbol name, bool *found);
+  Expression propagate(Expression e);
+};
+
+Expression *CopyPass::lookup(Symbol name, bool *found)
+{
+  for (size_t i = scope.size(); i-- > 0; )
+    if (scope[i].first == name) {
+      *found = true;
+      return &scope[i].second;
+    }
+  *found = false;
+  return NULL;
+}
+
+Expression CopyPass::run(Expression e, Formals formals)
+{
+  scope.clear();
+  for (Formal f : *formals)
+    scope.push_back(std::make_pair(f->get_name(), (Expression) NULL));
+  return propagate(e);
+}
+
+Expression CopyPass::propagate(Expression e)
+{
+  switch (e->get_kind()) {
+  case NODE_object: {
+    bool found;
+    Expression *r = lookup(static_cast<object_class *>(e)->name, &found);
+    if (!found || *r == NULL)
+      return e;
+    rewrites++;
+    Expression copy = (*r)->copy_Expression()->set_type((*r)->get_type());
+    copy->set(e);
+    return copy;
+  }
+  case NODE_let: {
+    let_class *t = static_cast<let_class *>(e);
+    t->init = propagate(t->init);
+    Expression r = NULL;
+    if (!assigns(t->body, t->identifier)) {
+      if (is_constant(t->init))
+        r = t->init;
+      else if (t->init->get_kind() == NODE_object) {
+        Symbol y = static_cast<object_class *>(t->init)->name;
+        bool local;
+        lookup(y, &local);
+        if ((y == self || local) && !assigns(t->body, y) && !binds(t->body, y))
+          r = t->init;
+      }
+    }
+    scope.push_back(std::make_pair(t->identifier, r));
+    t->body = propagate(t->body);
+    scope.pop_back();
+    return e;
+  }
+  case NODE_typcase: {
+    typcase_class *t = static_cast<typcase_class *>(e);
+    t->expr = propagate(t->expr);
+    for (Case c : *t->cases) {
+      branch_class *b = static_cast<branch_class *>(c);
+      scope.push_back(std::make_pair(b->name, (Expression) NULL));
+      b->expr = propagate(b->expr);
+      scope.pop_back();
+    }
+    return e;
+  }
+  default:
+    rewrite_children(e, [&](Expression c) { return propagate(c); });
+    return e;
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// fold: constant folding
+//
+// Arithmetic on Int constants is done as the code would do it, except
+// where the code would trap (an add, subtract or negate overflowing, a
+// division by zero or of the smallest Int by -1), which is left to the
+// code.  Comparisons of Int constants, = of two Int or two Bool
+// constants and not of a Bool constant become Bool constants.
+//
+//////////////////////////////////////////////////////////////////////
+
+class FoldPass : public OptPass {
+public:
+  FoldPass() : OptPass("fold") { }
+  Expression run(Expression e, Formals) { return fold(e); }
+
+private:
+  Expression fold(Expression e);
+};
+
+Expression FoldPass::fold(Expression e)
+{
+  rewrite_children(e, [&](Expression c) { return fold(c); });
+
+  int k = e->get_kind();
+  if (k == NODE_comp) {
+    Expression e1 = static_cast<comp_class *>(e)->e1;
+    if (e1->get_kind() != NODE_bool_const)
+      return e;
+    rewrites++;
+    return make_bool(!bool_value(e1), e);
+  }
+  if (k == NODE_neg) {
+    Expression e1 = static_cast<neg_class *>(e)->e1;
+    if (e1->get_kind() != NODE_int_const || int_value(e1) == INT_MIN)
+      return e;
+    rewrites++;
+    return make_int(-int_value(e1), e);
+  }
+  Expression *p1, *p2;
+  if (!e->binary_operands(p1, p2))
+    return e;
+
+  Expression e1 = *p1, e2 = *p2;
+  if (k == NODE_eq && e1->get_kind() == NODE_bool_const &&
+      e2->get_kind() == NODE_bool_const) {
+    rewrites++;
+    return make_bool(bool_value(e1) == bool_value(e2), e);
+  }
+  if (e1->get_kind() != NODE_int_const || e2->get_kind() != NODE_int_const)
+    return e;
+
+  long long a = int_value(e1), b = int_value(e2), r;
+  switch (k) {
+  case NODE_plus:   r = a + b; break;
+  case NODE_sub:    r = a - b; break;
+  case NODE_mul:    r = (int) ((unsigned) a * (unsigned) b); break;
+  case NODE_divide:
+    if (b == 0 || (a == INT_MIN && b == -1))
+      return e;
+    r = a / b;
+    break;
+  case NODE_lt:     rewrites++; return make_bool(a < b, e);
+  case NODE_eq:     rewrites++; return make_bool(a == b, e);
+  case NODE_leq:    rewrites++; return make_bool(a <= b, e);
+  default:          return e;
+  }
+  if (r < INT_MIN || r > INT_MAX)
+    return e;
+  rewrites++;
+  return make_int((int) r, e);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// branches: dead branch elimination
+//
+// A conditional with a constant predicate becomes the branch it takes.
+// A loop whose predicate is false never runs its body, which becomes
+// no_expr (the loop still has its value, void).
+//
+//////////////////////////////////////////////////////////////////////
+
+class BranchPass : public OptPass {
+public:
+  BranchPass() : OptPass("branches") { }
+  Expression run(Expression e, Formals) { return prune(e); }
+
+private:
+  Expression prune(Expression e);
+};
+
+Expression BranchPass::prune(Expression e)
+{
+  rewrite_children(e, [&](Expression c) { return prune(c); });
+
+  if (e->get_kind() == NODE_cond) {
+    cond_class *t = static_cast<cond_class *>(e);
+    if (t->pred->get_kind() != NODE_bool_const)
+      return e;
+    rewrites++;
+    return bool_value(t->pred) ? t->then_exp : t->else_exp;
+  }
+  if (e->get_kind() == NODE_loop) {
+    loop_class *t = static_cast<loop_class *>(e);
+    if (t->pred->get_kind() == NODE_bool_const && !bool_value(t->pred) &&
+        t->body->get_kind() != NODE_no_expr) {
+      rewrites++;
+      t->body = no_expr();
+      t->body->set(e);
+    }
+  }
+  return e;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// lets: unused let elimination
+//
+// A let whose body neither reads nor sets its variable becomes its
+// body, if computing the initializer has no effect: it is missing, a
+// constant or a variable.
+//
+//////////////////////////////////////////////////////////////////////
+
+class LetPass : public OptPass {
+public:
+  LetPass() : OptPass("lets") { }
+  Expression run(Expression e, Formals) { return remove(e); }
+
+private:
+  Expression remove(Expression e);
+};
+
+Expression LetPass::remove(Expression e)
+{
+  rewrite_children(e, [&](Expression c) { return remove(c); });
+
+  if (e->get_kind() != NODE_let)
+    return e;
+  let_class *t = static_cast<let_class *>(e);
+  int k = t->init->get_kind();
+  if (!(k == NODE_no_expr || k == NODE_object || is_constant(t->init)) ||
+      mentions(t->body, t->identifier))
+    return e;
+  rewrites++;
+  return t->body;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// The pass manager
+//
+//////////////////////////////////////////////////////////////////////
+
+// the most rounds the passes are run for
+#define MAX_ROUNDS 8
+
+PassManager::PassManager() : rounds(0)
+{
+  passes.push_back(new CopyPass());
+  passes.push_back(new FoldPass());
+  passes.push_back(new BranchPass());
+  passes.push_back(new LetPass());
+}
+
+PassManager::~PassManager()
+{
+  for (OptPass *p : passes)
+    delete p;
+}
+
+bool PassManager::disable(const char *names)
+{
+  bool ok = true;
+  std::string list(names);
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos)
+      end = list.size();
+    std::string name = list.substr(start, end - start);
+    bool found = false;
+    for (OptPass *p : passes)
+      if (name == p->name) {
+        p->enabled = false;
+        found = true;
+      }
+    ok = ok && found;
+    start = end + 1;
+  }
+  return ok;
+}
+
+//
+// One round: each enabled pass over each method and initializer.
+// Whether anything changed.
+//
+bool PassManager::run_round(Program program)
+{
+  long before = 0, after = 0;
+  for (OptPass *p : passes)
+    before += p->rewrites;
+
+  Classes classes = static_cast<program_class *>(program)->classes;
+  for (OptPass *p : passes) {
+    if (!p->enabled)
+      continue;
+    for (Class_ c : *classes)
+      for (Feature f : *c->get_features()) {
+        if (f->get_kind() == NODE_method) {
+          method_class *m = static_cast<method_class *>(f);
+          m->expr = p->run(m->expr, m->formals);
+        } else {
+          attr_class *a = static_cast<attr_class *>(f);
+          a->init = p->run(a->init, nil_Formals());
+        }
+      }
+  }
+
+  for (OptPass *p : passes)
+    after += p->rewrites;
+  return after != before;
+}
+
+void PassManager::run(Program program)
+{
+  while (rounds < MAX_ROUNDS) {
+    rounds++;
+    if (!run_round(program))
+      break;
+  }
+}
+
+bool check_pass_names(const char *names, ostream& errors)
+{
+  if (PassManager().disable(names))
+    return true;
+  errors << "-X " << names << ": not all of these are optimization passes"
+         << endl;
+  return false;
+}
+
+void PassManager::report(ostream& s)
+{
+  s << "optimized in " << rounds << (rounds == 1 ? " round:" : " rounds:");
+  for (OptPass *p : passes) {
+    s << " " << p->name << " ";
+    if (p->enabled)
+      s << p->rewrites;
+    else
+      s << "off";
+  }
+  s << endl;
+}
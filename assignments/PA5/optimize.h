@@ -0,0 +1,66 @@
+#ifndef _OPTIMIZE_H_
+#define _OPTIMIZE_H_
+
+//
+// The optimizations of the code generator (-O).  They rewrite the
+// typed tree of each method body and attribute initializer before any
+// code is generated, so the code generator sees only their result.
+//
+// Each pass is an OptPass: it rewrites one routine's expression and
+// counts the rewrites it made.  The PassManager runs the enabled passes
+// over every routine of the program, in turn, until a round of them
+// changes nothing, so that one pass's rewrites can give another more
+// to do (propagating a constant lets folding fold it, folding a
+// predicate lets a dead branch go).  The passes are
+//
+//    copies    uses of a let variable bound to a constant or to another
+//              local that neither is assigned in its body become the
+//              constant or that local
+//    fold      arithmetic and comparisons of constants
+//    branches  conditionals with a constant predicate, and the bodies of
+//              loops whose predicate is false
+//    lets      lets whose variable is not used, with an initializer
+//              that has no effect
+//
+// and -X takes a comma-separated list of those to leave out.  With -c
+// the manager reports each pass's rewrites.
+//
+#include <vector>
+#include "cool-tree.h"
+
+class OptPass {
+public:
+  OptPass(const char *n) : name(n), enabled(true), rewrites(0) { }
+  virtual ~OptPass() { }
+
+  const char *name;
+  bool enabled;
+  long rewrites;
+
+  // e, a routine's expression, rewritten; the formals are its locals
+  virtual Expression run(Expression e, Formals formals) = 0;
+};
+
+class PassManager {
+public:
+  PassManager();                        // all the passes, enabled
+  ~PassManager();
+
+  // Leave out the passes named in names (comma-separated); false if
+  // one of them is not a pass.
+  bool disable(const char *names);
+  void run(Program program);
+  void report(ostream& s);
+
+private:
+  std::vector<OptPass *> passes;
+  int rounds;
+
+  bool run_round(Program program);
+};
+
+// Whether names (as given to -X) are all passes; if not, says so on
+// errors.  The drivers check -X with it before compiling anything.
+bool check_pass_names(const char *names, ostream& errors);
+
+#endif
@@ -0,0 +1,233 @@
+//
+// peephole.cc
+//
+// The peephole optimizer; see peephole.h.
+//
+#include <sstream>
+#include "peephole.h"
+#include "emit.h"
+
+//
+// The lines of a routine's code.  An instruction is a tab, its opcode,
+// and its operands separated by spaces; a label is its name and a
+// colon; anything else (a directive) is neither.
+//
+static std::vector<AsmLine> read_lines(const std::string& code)
+{
+  std::vector<AsmLine> lines;
+  std::istringstream in(code);
+  std::string text;
+  while (std::getline(in, text)) {
+    AsmLine line;
+    line.text = text;
+    if (!text.empty() && text[0] != '\t' && text.back() == ':')
+      line.label = text.substr(0, text.size() - 1);
+    else if (text.size() > 1 && text[0] == '\t' && text[1] != '.') {
+      std::istringstream fields(text);
+      fields >> line.op;
+      std::string arg;
+      while (fields >> arg)
+        line.args.push_back(arg);
+    }
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+static AsmLine instruction(const char *op, std::vector<std::string> args)
+{
+  AsmLine line;
+  line.op = op;
+  line.args = args;
+  line.text = "\t" + line.op + "\t";
+  for (size_t a = 0; a < args.size(); a++)
+    line.text += (a ? " " : "") + args[a];
+  return line;
+}
+
+static bool is_branch(const AsmLine& l)
+{
+  return !l.op.empty() && l.op[0] == 'b';
+}
+
+static bool is_call(const AsmLine& l)
+{
+  return l.is("jal") || l.is("jalr");
+}
+
+// whether l (an instruction) may change register r
+static bool sets(const AsmLine& l, const std::string& r)
+{
+  if (is_call(l))
+    return true;
+  if (l.is("sw") || l.is("jr") || is_branch(l))
+    return false;
+  return !l.args.empty() && l.args[0] == r;
+}
+
+// register r loaded with register from, at line i (replacing it)
+static void replace_with_move(std::vector<AsmLine>& code, size_t i,
+                              const std::string& r, const std::string& from)
+{
+  if (r == from)
+    code.erase(code.begin() + i);
+  else
+    code[i] = instruction("move", {r, from});
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//
+// The rules.  Each one, given the code and a position in it, rewrites
+// the code there if it applies and says whether it did.
+//
+//////////////////////////////////////////////////////////////////////
+
+static bool self_move(std::vector<AsmLine>& code, size_t i)
+{
+  if (!code[i].is("move") || code[i].args[0] != code[i].args[1])
+    return false;
+  code.erase(code.begin() + i);
+  return true;
+}
+
+static bool move_back(std::vector<AsmLine>& code, size_t i)
+{
+  if (i + 1 >= code.size() || !code[i].is("move") || !code[i + 1].is("move"))
+    return false;
+  const std::vector<std::string>& a = code[i].args;
+  const std::vector<std::string>& b = code[i + 1].args;
+  if (a[0] != b[1] || a[1] != b[0])
+    return false;
+  code.erase(code.begin() + i + 1);
+  return true;
+}
+
+static bool self_void(std::vector<AsmLine>& code, size_t i)
+{
+  if (i + 1 >= code.size() || !code[i].is("move") || !code[i + 1].is("bne"))
+    return false;
+  const std::vector<std::string>& a = code[i].args;
+  const std::vector<std::string>& b = code[i + 1].args;
+  if (a[0] != ACC || a[1] != SELF || b[0] != ACC || b[1] != ZERO)
+    return false;
+  code[i + 1] = instruction("b", {b[2]});
+  return true;
+}
+
+static bool dead_code(std::vector<AsmLine>& code, size_t i)
+{
+  if (!code[i].is("b") && !code[i].is("jr"))
+    return false;
+  size_t end = i + 1;
+  while (end < code.size() && !code[end].op.empty())
+    end++;
+  if (end == i + 1)
+    return false;
+  code.erase(code.begin() + i + 1, code.begin() + end);
+  return true;
+}
+
+static bool jump_next(std::vector<AsmLine>& code, size_t i)
+{
+  if (!is_branch(code[i]))
+    return false;
+  const std::string& target = code[i].args.back();
+  for (size_t l = i + 1; l < code.size() && code[l].is_label(); l++)
+    if (code[l].label == target) {
+      code.erase(code.begin() + i);
+      return true;
+    }
+  return false;
+}
+
+static bool store_reload(std::vector<AsmLine>& code, size_t i)
+{
+  if (i + 1 >= code.size() || !code[i].is("sw") || !code[i + 1].is("lw") ||
+      code[i].args[1] != code[i + 1].args[1])
+    return false;
+  replace_with_move(code, i + 1, code[i + 1].args[0], code[i].args[0]);
+  return true;
+}
+
+static bool push_reload(std::vector<AsmLine>& code, size_t i)
+{
+  if (i + 2 >= code.size() || !code[i].is("sw") || !code[i + 1].is("addiu") ||
+      !code[i + 2].is("lw"))
+    return false;
+  std::string sp = SP;
+  if (code[i].args[1] != "0(" + sp + ")" ||
+      code[i + 1].args != std::vector<std::string>{sp, sp, "-4"} ||
+      code[i + 2].args[1] != "4(" + sp + ")")
+    return false;
+  replace_with_move(code, i + 2, code[i + 2].args[0], code[i].args[0]);
+  return true;
+}
+
+static bool reload_la(std::vector<AsmLine>& code, size_t i)
+{
+  if (!code[i].is("la"))
+    return false;
+  const std::string& r = code[i].args[0];
+  for (size_t l = i + 1; l < code.size() && !code[l].op.empty(); l++) {
+    if (code[l].is("la") && code[l].args == code[i].args) {
+      code.erase(code.begin() + l);
+      return true;
+    }
+    if (sets(code[l], r))
+      return false;
+  }
+  return false;
+}
+
+static const struct {
+  const char *name;
+  bool (*apply)(std::vector<AsmLine>& code, size_t i);
+} rules[] = {
+  { "self-move",    self_move },
+  { "move-back",    move_back },
+  { "self-void",    self_void },
+  { "dead-code",    dead_code },
+  { "jump-next",    jump_next },
+  { "store-reload", store_reload },
+  { "push-reload",  push_reload },
+  { "reload-la",    reload_la },
+};
+static const int NRULES = sizeof(rules) / sizeof(rules[0]);
+
+Peephole::Peephole() : fires(NRULES, 0) { }
+
+static int instructions(const std::vector<AsmLine>& code)
+{
+  int n = 0;
+  for (const AsmLine& l : code)
+    if (!l.op.empty())
+      n++;
+  return n;
+}
+
+int Peephole::run(const std::string& text, ostream& s)
+{
+  std::vector<AsmLine> code = read_lines(text);
+  int before = instructions(code);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < code.size(); i++)
+      for (int r = 0; r < NRULES && i < code.size(); r++)
+        if (rules[r].apply(code, i)) {
+          fires[r]++;
+          changed = true;
+        }
+  }
+  for (const AsmLine& l : code)
+    s << l.text << endl;
+  return before - instructions(code);
+}
+
+void Peephole::report(ostream& s)
+{
+  s << "peephole rules:" << endl;
+  for (int r = 0; r < NRULES; r++)
+    s << "  " << rules[r].name << ": " << fires[r] << endl;
+}
@@ -0,0 +1,56 @@
+#ifndef _PEEPHOLE_H_
+#define _PEEPHOLE_H_
+
+//
+// The peephole optimizer of the code generator (-O).  The code of each
+// routine is emitted into a buffer rather than straight to the output;
+// run reads it back as a list of lines (labels and instructions),
+// rewrites the list with the rules of its table until none applies, and
+// writes it out.  Each rule looks at the lines from one position on and
+// counts the times it fires.  The rules are
+//
+//    self-move     move R R                        dropped
+//    move-back     move A B; move B A              the second dropped
+//    self-void     move $a0 $s0; bne $a0 $zero L   b L (self is never void)
+//    dead-code     instructions after b or jr, up to the next label,
+//                  dropped
+//    jump-next     a branch to a label that follows it at once, dropped
+//    store-reload  sw R x(B); lw R' x(B)           move R' R
+//    push-reload   sw R 0($sp); addiu $sp $sp -4; lw R' 4($sp)
+//                                                  move R' R
+//    reload-la     la R X; ...; la R X             the second dropped, if
+//                                                  nothing between sets R
+//                                                  or is a label or a call
+//
+// so one rule's rewrite can give another something to do: a void check
+// of self becomes a branch over dead code, then nothing at all.  With -c
+// the code generator reports the times each rule fired.
+//
+#include <string>
+#include <vector>
+#include "cool-io.h"
+
+struct AsmLine {
+  std::string label;                  // for a label; else empty
+  std::string op;                     // for an instruction; else empty
+  std::vector<std::string> args;
+  std::string text;                   // the line as it is written out
+
+  bool is_label() const { return !label.empty(); }
+  bool is(const char *o) const { return op == o; }
+};
+
+class Peephole {
+public:
+  Peephole();
+
+  // Writes code, a routine's, to s rewritten; the number of
+  // instructions that are gone.
+  int run(const std::string& code, ostream& s);
+  void report(ostream& s);
+
+private:
+  std::vector<long> fires;            // by rule
+};
+
+#endif
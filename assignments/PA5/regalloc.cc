@@ -0,0 +1,85 @@
+//
+// regalloc.cc
+//
+// Linear-scan register allocation; see regalloc.h.
+//
+#include <algorithm>
+#include "regalloc.h"
+
+LinearScan::LinearScan(char *const *s, int nsaved, char *const *t,
+                       int nscratch)
+  : saved(s, s + nsaved), scratch(t, t + nscratch),
+    saved_taken(nsaved, false)
+{ }
+
+void LinearScan::allocate(std::vector<LiveInterval>& intervals)
+{
+  std::vector<int> order(intervals.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    if (intervals[a].start != intervals[b].start)
+      return intervals[a].start < intervals[b].start;
+    return a < b;
+  });
+
+  // The registers in use, each with the interval holding it; the
+  // saved registers come first.
+  int nregs = saved.size() + scratch.size();
+  std::vector<int> holder(nregs, -1);
+  auto name = [&](int r) {
+    return r < (int) saved.size() ? saved[r] : scratch[r - saved.size()];
+  };
+
+  for (int i : order) {
+    LiveInterval& cur = intervals[i];
+    for (int r = 0; r < nregs; r++)
+      if (holder[r] >= 0 && intervals[holder[r]].end < cur.start)
+        holder[r] = -1;
+
+    // A free register: scratch first, unless the interval spans a call.
+    int free_reg = -1;
+    if (!cur.across_call)
+      for (int r = saved.size(); r < nregs && free_reg < 0; r++)
+        if (holder[r] < 0)
+          free_reg = r;
+    bool cheap = !cur.across_call || cur.spill_cost > 2;
+    for (int r = 0; r < (int) saved.size() && free_reg < 0; r++)
+      if (holder[r] < 0 && (cheap || saved_taken[r]))
+        free_reg = r;
+
+    if (free_reg < 0) {
+      // Spill whichever of the intervals whose register cur may have
+      // ends last.
+      int victim = -1;
+      int limit = cur.across_call ? saved.size() : nregs;
+      for (int r = 0; r < limit; r++)
+        if ((cheap || saved_taken[r]) &&
+            (victim < 0 ||
+             intervals[holder[r]].end > intervals[holder[victim]].end))
+          victim = r;
+      if (victim >= 0 && intervals[holder[victim]].end > cur.end) {
+        intervals[holder[victim]].reg = NULL;
+        free_reg = victim;
+      }
+    }
+
+    if (free_reg < 0) {
+      cur.reg = NULL;
+      continue;
+    }
+    holder[free_reg] = i;
+    cur.reg = name(free_reg);
+    if (free_reg < (int) saved.size())
+      saved_taken[free_reg] = true;
+  }
+}
+
+std::vector<char *> LinearScan::saved_used() const
+{
+  std::vector<char *> used;
+  for (size_t r = 0; r < saved.size(); r++)
+    if (saved_taken[r])
+      used.push_back(saved[r]);
+  return used;
+}
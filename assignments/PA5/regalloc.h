@@ -0,0 +1,44 @@
+#ifndef _REGALLOC_H_
+#define _REGALLOC_H_
+
+//
+// Linear-scan register allocation (Poletto and Sarkar) of the
+// temporaries of a method.  A temporary lives from the position where
+// it is set to the position of its last use; the positions number the
+// points of the method's code in the order it is generated.
+//
+// Two sets of registers are handed out: those a call preserves (the
+// callee saves them) and those it does not.  A temporary live across a
+// call can only have one of the first; one that is not prefers the
+// second, which cost nothing to save.  When all the registers it may
+// have are taken, the temporary among it and the active ones that ends
+// last is spilled, and keeps its value in the frame.
+//
+#include <vector>
+
+struct LiveInterval {
+  int start;                  // position of the first definition
+  int end;                    // position of the last use
+  bool across_call;           // a call lies in (start, end)
+  int spill_cost;             // the loads and stores spilling adds
+  char *reg;                  // what it was given; NULL if spilled
+};
+
+class LinearScan {
+public:
+  LinearScan(char *const *saved, int nsaved, char *const *scratch,
+             int nscratch);
+
+  // Give a register to each interval, or spill it.
+  void allocate(std::vector<LiveInterval>& intervals);
+
+  // The callee-saved registers given out, in the order of `saved'.
+  std::vector<char *> saved_used() const;
+
+private:
+  std::vector<char *> saved;
+  std::vector<char *> scratch;
+  std::vector<bool> saved_taken;        // ever given out
+};
+
+#endif
@@ -14,9 +14,11 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "tree.h"
+#include "stats.h"
 
-/* line number to assign to the current node being constructed */
-int node_lineno = 1;
+/* line number to assign to the current node being constructed; per
+   thread, since coolc runs a parser on each of several threads */
+thread_local int node_lineno = 1;
 
 ///////////////////////////////////////////////////////////////////////////
 //
@@ -28,6 +30,8 @@ int node_lineno = 1;
 tree_node::tree_node()
 {
     line_number = node_lineno;
+    kind = 0;
+    stat_counters.tree_nodes++;
 }
 
 ///////////////////////////////////////////////////////////////////////////
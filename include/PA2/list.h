@@ -21,6 +21,7 @@
 
 #include "cool-io.h"  //includes iostream
 #include <stdlib.h>
+#include "arena.h"
 
 template <class T>
 class List {
@@ -28,6 +29,7 @@ private:
   T *head;
   List<T>* tail;
 public:
+  ARENA_ALLOCATED   // cells live in the compilation arena
   List(T *h,List<T>* t = NULL): head(h), tail(t) { }
 
   T *hd() const       { return head; }  
@@ -6,16 +6,60 @@
 
 #include "cool-io.h"
 #define MAXSIZE 1000000
-#define min(a,b) (a > b ? b : a)
 
 #include "stringtab.h"
 #include <stdio.h>
+#include <algorithm>
 
 //
-// A string table is implemented a linked list of Entrys.  Each Entry
-// in the list has a unique string.
+// A string table is an array of Entrys indexed by their index, plus an
+// open-addressing hash table (linear probing) over the same Entrys keyed
+// by their strings.  Each Entry in the table has a unique string.
 //
 
+//
+// FNV-1a hash of the first len characters of s.
+//
+static inline unsigned int hash_string(char *s, int len)
+{
+  unsigned int h = 2166136261u;
+  for (int i = 0; i < len; i++)
+    h = (h ^ (unsigned char) s[i]) * 16777619u;
+  return h;
+}
+
+//
+// Return the bucket holding the entry for the first len characters of s,
+// or, if there is none, the empty bucket where it would go.
+//
+template <class Elem>
+int StringTable<Elem>::find(char *s, int len)
+{
+  int mask = nbuckets - 1;
+  searches++;
+  for (int b = hash_string(s,len) & mask; ; b = (b + 1) & mask) {
+    probes++;
+    if (buckets[b] == 0 || tbl[buckets[b] - 1]->equal_string(s,len))
+      return b;
+  }
+}
+
+template <class Elem>
+void StringTable<Elem>::rehash(int n)
+{
+  delete [] buckets;
+  buckets = new int[n];
+  nbuckets = n;
+  for (int b = 0; b < n; b++)
+    buckets[b] = 0;
+  // reinserting the entries does not count in the statistics
+  long old_searches = searches, old_probes = probes;
+  for (int i = 0; i < index; i++)
+    buckets[find(tbl[i]->get_string(), tbl[i]->get_len())] = i + 1;
+  searches = old_searches;
+  probes = old_probes;
+}
+
 template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s)
 {
@@ -23,38 +67,64 @@ Elem *StringTable<Elem>::add_string(char *s)
 }
 
 //
-// Add a string requires two steps.  First, the list is searched; if the
-// string is found, a pointer to the existing Entry for that string is 
-// returned.  If the string is not found, a new Entry is created and added
-// to the list.
+// Add a string requires two steps.  First, the hash table is searched; if
+// the string is found, a pointer to the existing Entry for that string is
+// returned.  If the string is not found, a new Entry is created with the
+// next index and entered into both tables.  s need not be null terminated
+// if it is at least maxchars long.
 //
 template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s, int maxchars)
 {
-  int len = min((int) strlen(s),maxchars);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
+  int len = strnlen(s,maxchars);
+  if (!concurrent)
+    return add(s,len);
 
-  Elem *e = new Elem(s,len,index++);
-  tbl = new List<Elem>(e, tbl);
+  std::lock_guard<std::mutex> guard(lock);
+  unsigned long order = intern_order++;
+  int old_index = index;
+  Elem *e = add(s,len);
+  if (index > old_index || e->order > order)
+    e->order = order;
+  return e;
+}
+
+template <class Elem>
+Elem *StringTable<Elem>::add(char *s, int len)
+{
+  if (2 * (index + 1) > nbuckets)
+    rehash(nbuckets ? 2 * nbuckets : 256);
+  int b = find(s,len);
+  if (buckets[b])
+    return tbl[buckets[b] - 1];
+
+  if (index == size) {
+    size = size ? 2 * size : 128;
+    Elem **t = new Elem *[size];
+    for (int i = 0; i < index; i++)
+      t[i] = tbl[i];
+    delete [] tbl;
+    tbl = t;
+  }
+  Elem *e = new Elem(s,len,index);
+  tbl[index++] = e;
+  buckets[b] = index;
   return e;
 }
 
 //
-// To look up a string, the list is scanned until a matching Entry is located.
-// If no such entry is found, an assertion failure occurs.  Thus, this function
-// is used only for strings that one expects to find in the table.
+// To look up a string, the hash table is probed until a matching Entry is
+// located.  If no such entry is found, an assertion failure occurs.  Thus,
+// this function is used only for strings that one expects to find in the
+// table.
 //
 template <class Elem>
 Elem *StringTable<Elem>::lookup_string(char *s)
 {
-  int len = strlen(s);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(nbuckets > 0);   // fail if the table is empty
+  int b = find(s,strlen(s));
+  assert(buckets[b]);     // fail if string is not found
+  return tbl[buckets[b] - 1];
 }
 
 //
@@ -64,11 +134,8 @@ Elem *StringTable<Elem>::lookup_string(char *s)
 template <class Elem>
 Elem *StringTable<Elem>::lookup(int ind)
 {
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_index(ind))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(0 <= ind && ind < index);   // fail if string is not found
+  return tbl[ind];
 }
 
 //
@@ -77,7 +144,7 @@ Elem *StringTable<Elem>::lookup(int ind)
 template <class Elem>
 Elem *StringTable<Elem>::add_int(int i)
 {
-  static char *buf = new char[20];
+  char buf[20];
   snprintf(buf, 20, "%d", i);
   return add_string(buf);
 }
@@ -100,8 +167,46 @@ int StringTable<Elem>::next(int i)
   return i+1;
 }
 
+template <class Elem>
+void StringTable<Elem>::clear()
+{
+  index = 0;
+  for (int b = 0; b < nbuckets; b++)
+    buckets[b] = 0;
+}
+
+//
+// The entries that exist before begin_concurrent get order 0, so they
+// keep their indices; the rest are sorted by the order of first use.
+//
+template <class Elem>
+void StringTable<Elem>::begin_concurrent()
+{
+  for (int i = 0; i < index; i++)
+    tbl[i]->order = 0;
+  concurrent = true;
+}
+
+template <class Elem>
+void StringTable<Elem>::end_concurrent()
+{
+  concurrent = false;
+  std::stable_sort(tbl, tbl + index,
+                   [](Elem *a, Elem *b) { return a->order < b->order; });
+  for (int i = 0; i < index; i++)
+    tbl[i]->index = i;
+  if (nbuckets > 0)
+    rehash(nbuckets);
+}
+
+//
+// print lists the entries newest first.
+//
 template <class Elem>
 void StringTable<Elem>::print()
 {
-  list_print(cerr,tbl);
+  cerr << "[\n";
+  for (int i = index - 1; i >= 0; i--)
+    cerr << *tbl[i] << " ";
+  cerr << "]\n";
 }
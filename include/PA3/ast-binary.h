@@ -0,0 +1,96 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _AST_BINARY_H
+#define _AST_BINARY_H
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ast-binary.h
+//
+//  A compact binary encoding of the (possibly typed) AST, used by the
+//  phases as an alternative to the text format written by dump_with_types
+//  and read back by ast_yyparse.  Every phase that reads an AST accepts
+//  either format; a phase writes the binary format when given -b.
+//
+//  All numbers are unsigned LEB128 varints.  A file is laid out as
+//
+//     magic        the four bytes \177 A S T
+//     version      AST_BINARY_VERSION
+//     symbols      a count, then for each symbol its table (AST_IDTABLE,
+//                  AST_STRTABLE or AST_INTTABLE), its length and its bytes
+//     tree         the program node
+//
+//  and a node is its kind (AstKind), its line number and then its fields
+//  in the order dump_with_types prints them.  A Symbol field is its
+//  position in the symbol section plus one, 0 standing for NULL; a list
+//  is its length followed by its elements; an Expression is followed by
+//  its type.  Each symbol is thus written once however often it is used,
+//  and symbols are entered into the tables in the same order as when
+//  the text format is read.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string>
+#include <map>
+#include "cool-io.h"
+#include "cool-tree.h"
+
+#define AST_BINARY_VERSION 1
+
+enum AstTable { AST_IDTABLE, AST_STRTABLE, AST_INTTABLE };
+
+enum AstKind {
+  AST_program = 1, AST_class_, AST_method, AST_attr, AST_formal, AST_branch,
+  AST_assign, AST_static_dispatch, AST_dispatch, AST_cond, AST_loop,
+  AST_typcase, AST_block, AST_let, AST_plus, AST_sub, AST_mul, AST_divide,
+  AST_neg, AST_lt, AST_eq, AST_leq, AST_comp, AST_int_const, AST_bool_const,
+  AST_string_const, AST_new_, AST_isvoid, AST_no_expr, AST_object
+};
+
+//
+// The nodes encode themselves through dump_binary, which appends to an
+// AstWriter.  The symbol section is only known once the whole tree has
+// been visited, so the node records are buffered until write().
+//
+class AstWriter {
+private:
+  std::string symbols;               // the encoded symbol section
+  std::string nodes;                 // the encoded tree
+  int num_symbols;
+  std::map<Symbol,int> index;        // symbol -> position + 1
+  void put(std::string& buf, unsigned int n);
+  void symbol(Symbol s, AstTable table);
+public:
+  AstWriter() : num_symbols(0) { }
+  void node(AstKind kind, tree_node *t);
+  void id(Symbol s)       { symbol(s, AST_IDTABLE); }
+  void str(Symbol s)      { symbol(s, AST_STRTABLE); }
+  void integer(Symbol s)  { symbol(s, AST_INTTABLE); }
+  void boolean(Boolean b) { put(nodes, b ? 1 : 0); }
+  void length(int n)      { put(nodes, n); }
+  void write(ostream& stream);
+};
+
+//
+// Write the tree rooted at p to stream in the binary format.
+//
+void dump_ast_binary(ostream& stream, Program p);
+
+//
+// Peek at the first byte of f: true if it starts a binary AST.  Nothing
+// is consumed, so the text parser may be run on f otherwise.
+//
+bool is_ast_binary(FILE *f);
+
+//
+// Read a binary AST from f, entering its symbols into the string tables.
+// If the input is malformed, say so on errors and return NULL.
+//
+Program read_ast_binary(FILE *f, ostream& errors);
+
+#endif
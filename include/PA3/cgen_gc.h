@@ -4,12 +4,17 @@
 //
 #include "copyright.h"
 
+#ifndef _CGEN_GC_H_
+#define _CGEN_GC_H_
+
 //
-// Garbage collection options
+// Garbage collection options (per thread; see handle_flags.cc)
 //
 
-extern enum Memmgr { GC_NOGC, GC_GENGC, GC_SNCGC } cgen_Memmgr;
+extern thread_local enum Memmgr { GC_NOGC, GC_GENGC, GC_SNCGC } cgen_Memmgr;
+
+extern thread_local enum Memmgr_Test { GC_NORMAL, GC_TEST } cgen_Memmgr_Test;
 
-extern enum Memmgr_Test { GC_NORMAL, GC_TEST } cgen_Memmgr_Test;
+extern thread_local enum Memmgr_Debug { GC_QUICK, GC_DEBUG } cgen_Memmgr_Debug;
 
-extern enum Memmgr_Debug { GC_QUICK, GC_DEBUG } cgen_Memmgr_Debug;
+#endif
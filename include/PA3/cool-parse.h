@@ -171,7 +171,8 @@ typedef union YYSTYPE
 # define YYSTYPE_IS_TRIVIAL 1
 #endif
 
-extern YYSTYPE cool_yylval;
+/* the value of the lexer's last token; per thread, like the lexer */
+extern thread_local YYSTYPE cool_yylval;
 
 #if ! defined YYLTYPE && ! defined YYLTYPE_IS_DECLARED
 typedef struct YYLTYPE
@@ -186,5 +187,4 @@ typedef struct YYLTYPE
 # define YYLTYPE_IS_TRIVIAL 1
 #endif
 
-extern YYLTYPE cool_yylloc;
 #endif
@@ -11,6 +11,7 @@
 
 #include <assert.h>
 #include <string.h>
+#include <mutex>
 #include "list.h"    // list template
 #include "cool-io.h"
 
@@ -31,7 +32,11 @@ protected:
   char *str;     // the string
   int  len;      // the length of the string (without trailing \0)
   int index;     // a unique index for each string
+  unsigned long order;  // first use while concurrent; see end_concurrent
+
+  template <class Elem> friend class StringTable;
 public:
+  ARENA_ALLOCATED       // entries and their strings live in the arena
   Entry(char *s, int l, int i);
 
   // is string argument equal to the str of this Entry?
@@ -45,6 +50,9 @@ public:
   // Return the str and len components of the Entry.
   char *get_string() const;
   int get_len() const;
+
+  // The index, dense in its table (for vectors indexed by symbol).
+  int get_index() const { return index; }
 };
 
 //
@@ -93,10 +101,25 @@ template <class Elem>
 class StringTable
 {
 protected:
-   List<Elem> *tbl;   // a string table is a list
-   int index;         // the current index
+   Elem **tbl;        // tbl[i] is the entry with index i
+   int index;         // the current index; also the number of entries
+   int size;          // allocated length of tbl
+   int *buckets;      // hash of the entries by string: index+1, 0 if empty
+   int nbuckets;      // length of buckets; a power of 2, at least 2*index
+
+   bool concurrent;   // add_string takes lock (see begin_concurrent)
+   std::mutex lock;
+
+   long searches;     // calls of find, for the statistics (-P)
+   long probes;       // buckets they examined
+
+   int find(char *s, int len);   // bucket holding s, or the empty one to use
+   void rehash(int n);           // rebuild buckets with n slots
+   Elem *add(char *s, int len);  // add_string without the locking
 public:
-   StringTable(): tbl((List<Elem> *) NULL), index(0) { }   // an empty table
+   StringTable(): tbl((Elem **) NULL), index(0), size(0),
+                  buckets((int *) NULL), nbuckets(0),
+                  concurrent(false), searches(0), probes(0) { }  // an empty table
    // The following methods each add a string to the string table.  
    // Only one copy of each string is maintained.  
    // Returns a pointer to the string table entry with the string.
@@ -121,6 +144,21 @@ public:
 
    void print();  // print the entire table; for debugging
 
+   int num_entries() const   { return index; }
+   int num_buckets() const   { return nbuckets; }
+   long num_searches() const { return searches; }
+   long num_probes() const   { return probes; }
+
+   // forget all entries; done before the arena holding them is released
+   void clear();
+
+   // Between these calls, several threads may call add_string (and only
+   // add_string) at once.  Each entry remembers the smallest intern_order
+   // it was added with, and end_concurrent renumbers the entries in that
+   // order, so that the indices do not depend on how the threads ran.
+   void begin_concurrent();
+   void end_concurrent();
+
 };
 
 class IdTable : public StringTable<IdEntry> { };
@@ -137,7 +175,30 @@ public:
    void code_string_table(ostream&, int classtag);
 };
 
-extern IdTable idtable;
-extern IntTable inttable;
-extern StrTable stringtable;
+//
+// The position of this thread's next add_string in the order a single
+// thread would have made the calls; used while tables are concurrent.
+// The front end gives each file a range of its own (see libcoolc.cc).
+//
+extern thread_local unsigned long intern_order;
+
+//
+// The string tables of a compilation.  idtable, inttable and stringtable
+// are those of the compilation the current thread works on: string_tables
+// is per thread, and starts out pointing at a set shared by the whole
+// process.  A CompilerContext (libcoolc.h) points the threads working for
+// it at its own set, so that compilations on different threads do not
+// share symbols.
+//
+struct StringTables {
+  IdTable ids;
+  IntTable ints;
+  StrTable strings;
+};
+
+extern thread_local StringTables *string_tables;
+
+#define idtable     (string_tables->ids)
+#define inttable    (string_tables->ints)
+#define stringtable (string_tables->strings)
 #endif
@@ -12,7 +12,7 @@
 
 extern char *cool_token_to_string(int tok);
 extern void print_cool_token(int tok);
-extern void fatal_error(char *);
+extern void print_cool_token(ostream& out, int tok);
 extern void print_escaped_string(ostream& str, const char *s);
 extern char *pad(int);
 /*  On some machines strdup is not in the standard library. */
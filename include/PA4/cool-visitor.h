@@ -0,0 +1,314 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _COOL_VISITOR_H_
+#define _COOL_VISITOR_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  cool-visitor.h
+//
+//  A visitor over the Cool tree that dispatches on the nodes' kinds
+//  (see NodeKind in cool-tree.handcode.h) with a switch rather than
+//  through virtual functions, so that the compiler can inline the
+//  visit functions into it.  A pass derives from TreeVisitor, naming
+//  itself and the result type, and defines the visit functions it
+//  needs; the others fall back from a constructor to its phylum
+//  (visit_plus to visit_Expression) and from a phylum to visit_node,
+//  which returns R().  For instance, counting the dispatches in an
+//  expression (visit does not descend; a pass walks the children it
+//  wants itself):
+//
+//      struct DispatchCounter : TreeVisitor<DispatchCounter, int> {
+//        int visit_dispatch(dispatch_class *) { return 1; }
+//        int visit_static_dispatch(static_dispatch_class *) { return 1; }
+//      };
+//
+//      DispatchCounter().visit(e)
+//
+//  walk_tree calls a function on every node of a subtree.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "cool-tree.h"
+
+template <class V, class R = void>
+class TreeVisitor {
+public:
+  R visit(tree_node *n);
+
+  R visit_node(tree_node *) { return R(); }
+  R visit_Program(Program_class *n) { return self().visit_node(n); }
+  R visit_Class_(Class__class *n) { return self().visit_node(n); }
+  R visit_Feature(Feature_class *n) { return self().visit_node(n); }
+  R visit_Formal(Formal_class *n) { return self().visit_node(n); }
+  R visit_Case(Case_class *n) { return self().visit_node(n); }
+  R visit_Expression(Expression_class *n) { return self().visit_node(n); }
+
+  R visit_program(program_class *n) { return self().visit_Program(n); }
+  R visit_class_(class__class *n) { return self().visit_Class_(n); }
+  R visit_method(method_class *n) { return self().visit_Feature(n); }
+  R visit_attr(attr_class *n) { return self().visit_Feature(n); }
+  R visit_formal(formal_class *n) { return self().visit_Formal(n); }
+  R visit_branch(branch_class *n) { return self().visit_Case(n); }
+  R visit_assign(assign_class *n) { return self().visit_Expression(n); }
+  R visit_static_dispatch(static_dispatch_class *n) { return self().visit_Expression(n); }
+  R visit_dispatch(dispatch_class *n) { return self().visit_Expression(n); }
+  R visit_cond(cond_class *n) { return self().visit_Expression(n); }
+  R visit_loop(loop_class *n) { return self().visit_Expression(n); }
+  R visit_typcase(typcase_class *n) { return self().visit_Expression(n); }
+  R visit_block(block_class *n) { return self().visit_Expression(n); }
+  R visit_let(let_class *n) { return self().visit_Expression(n); }
+  R visit_plus(plus_class *n) { return self().visit_Expression(n); }
+  R visit_sub(sub_class *n) { return self().visit_Expression(n); }
+  R visit_mul(mul_class *n) { return self().visit_Expression(n); }
+  R visit_divide(divide_class *n) { return self().visit_Expression(n); }
+  R visit_neg(neg_class *n) { return self().visit_Expression(n); }
+  R visit_lt(lt_class *n) { return self().visit_Expression(n); }
+  R visit_eq(eq_class *n) { return self().visit_Expression(n); }
+  R visit_leq(leq_class *n) { return self().visit_Expression(n); }
+  R visit_comp(comp_class *n) { return self().visit_Expression(n); }
+  R visit_int_const(int_const_class *n) { return self().visit_Expression(n); }
+  R visit_bool_const(bool_const_class *n) { return self().visit_Expression(n); }
+  R visit_string_const(string_const_class *n) { return self().visit_Expression(n); }
+  R visit_new_(new__class *n) { return self().visit_Expression(n); }
+  R visit_isvoid(isvoid_class *n) { return self().visit_Expression(n); }
+  R visit_no_expr(no_expr_class *n) { return self().visit_Expression(n); }
+  R visit_object(object_class *n) { return self().visit_Expression(n); }
+
+private:
+  V& self() { return *static_cast<V *>(this); }
+};
+
+template <class V, class R>
+R TreeVisitor<V, R>::visit(tree_node *n)
+{
+  switch (n->get_kind()) {
+  case NODE_program:
+    return self().visit_program(static_cast<program_class *>(n));
+  case NODE_class_:
+    return self().visit_class_(static_cast<class__class *>(n));
+  case NODE_method:
+    return self().visit_method(static_cast<method_class *>(n));
+  case NODE_attr:
+    return self().visit_attr(static_cast<attr_class *>(n));
+  case NODE_formal:
+    return self().visit_formal(static_cast<formal_class *>(n));
+  case NODE_branch:
+    return self().visit_branch(static_cast<branch_class *>(n));
+  case NODE_assign:
+    return self().visit_assign(static_cast<assign_class *>(n));
+  case NODE_static_dispatch:
+    return self().visit_static_dispatch(static_cast<static_dispatch_class *>(n));
+  case NODE_dispatch:
+    return self().visit_dispatch(static_cast<dispatch_class *>(n));
+  case NODE_cond:
+    return self().visit_cond(static_cast<cond_class *>(n));
+  case NODE_loop:
+    return self().visit_loop(static_cast<loop_class *>(n));
+  case NODE_typcase:
+    return self().visit_typcase(static_cast<typcase_class *>(n));
+  case NODE_block:
+    return self().visit_block(static_cast<block_class *>(n));
+  case NODE_let:
+    return self().visit_let(static_cast<let_class *>(n));
+  case NODE_plus:
+    return self().visit_plus(static_cast<plus_class *>(n));
+  case NODE_sub:
+    return self().visit_sub(static_cast<sub_class *>(n));
+  case NODE_mul:
+    return self().visit_mul(static_cast<mul_class *>(n));
+  case NODE_divide:
+    return self().visit_divide(static_cast<divide_class *>(n));
+  case NODE_neg:
+    return self().visit_neg(static_cast<neg_class *>(n));
+  case NODE_lt:
+    return self().visit_lt(static_cast<lt_class *>(n));
+  case NODE_eq:
+    return self().visit_eq(static_cast<eq_class *>(n));
+  case NODE_leq:
+    return self().visit_leq(static_cast<leq_class *>(n));
+  case NODE_comp:
+    return self().visit_comp(static_cast<comp_class *>(n));
+  case NODE_int_const:
+    return self().visit_int_const(static_cast<int_const_class *>(n));
+  case NODE_bool_const:
+    return self().visit_bool_const(static_cast<bool_const_class *>(n));
+  case NODE_string_const:
+    return self().visit_string_const(static_cast<string_const_class *>(n));
+  case NODE_new_:
+    return self().visit_new_(static_cast<new__class *>(n));
+  case NODE_isvoid:
+    return self().visit_isvoid(static_cast<isvoid_class *>(n));
+  case NODE_no_expr:
+    return self().visit_no_expr(static_cast<no_expr_class *>(n));
+  case NODE_object:
+    return self().visit_object(static_cast<object_class *>(n));
+  default:
+    return self().visit_node(n);
+  }
+}
+
+//
+// Whether n is an Expression (its kind is one of the expressions').
+//
+inline bool is_expression(tree_node const *n)
+  { return n->get_kind() >= NODE_assign && n->get_kind() <= NODE_object; }
+
+//
+// Call f(node) on n and on every node below it but the lists, in
+// preorder and in the order of each constructor's fields.  This reads
+// the nodes' fields, which are public in the cool-tree.h of the checker
+// and of the code generator.
+//
+template <class F> void walk_tree(tree_node *n, F& f);
+
+template <class F, class Elem> void walk_list(list_node<Elem> *l, F& f)
+{
+  for (Elem e : *l)
+    walk_tree(e, f);
+}
+
+template <class F> void walk_tree(tree_node *n, F& f)
+{
+  f(n);
+  switch (n->get_kind()) {
+  case NODE_program: {
+    program_class *t = static_cast<program_class *>(n);
+    walk_list(t->classes, f);
+    break;
+  }
+  case NODE_class_: {
+    class__class *t = static_cast<class__class *>(n);
+    walk_list(t->features, f);
+    break;
+  }
+  case NODE_method: {
+    method_class *t = static_cast<method_class *>(n);
+    walk_list(t->formals, f);
+    walk_tree(t->expr, f);
+    break;
+  }
+  case NODE_attr: {
+    attr_class *t = static_cast<attr_class *>(n);
+    walk_tree(t->init, f);
+    break;
+  }
+  case NODE_branch: {
+    branch_class *t = static_cast<branch_class *>(n);
+    walk_tree(t->expr, f);
+    break;
+  }
+  case NODE_assign: {
+    assign_class *t = static_cast<assign_class *>(n);
+    walk_tree(t->expr, f);
+    break;
+  }
+  case NODE_static_dispatch: {
+    static_dispatch_class *t = static_cast<static_dispatch_class *>(n);
+    walk_tree(t->expr, f);
+    walk_list(t->actual, f);
+    break;
+  }
+  case NODE_dispatch: {
+    dispatch_class *t = static_cast<dispatch_class *>(n);
+    walk_tree(t->expr, f);
+    walk_list(t->actual, f);
+    break;
+  }
+  case NODE_cond: {
+    cond_class *t = static_cast<cond_class *>(n);
+    walk_tree(t->pred, f);
+    walk_tree(t->then_exp, f);
+    walk_tree(t->else_exp, f);
+    break;
+  }
+  case NODE_loop: {
+    loop_class *t = static_cast<loop_class *>(n);
+    walk_tree(t->pred, f);
+    walk_tree(t->body, f);
+    break;
+  }
+  case NODE_typcase: {
+    typcase_class *t = static_cast<typcase_class *>(n);
+    walk_tree(t->expr, f);
+    walk_list(t->cases, f);
+    break;
+  }
+  case NODE_block: {
+    block_class *t = static_cast<block_class *>(n);
+    walk_list(t->body, f);
+    break;
+  }
+  case NODE_let: {
+    let_class *t = static_cast<let_class *>(n);
+    walk_tree(t->init, f);
+    walk_tree(t->body, f);
+    break;
+  }
+  case NODE_plus: {
+    plus_class *t = static_cast<plus_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_sub: {
+    sub_class *t = static_cast<sub_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_mul: {
+    mul_class *t = static_cast<mul_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_divide: {
+    divide_class *t = static_cast<divide_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_neg: {
+    neg_class *t = static_cast<neg_class *>(n);
+    walk_tree(t->e1, f);
+    break;
+  }
+  case NODE_lt: {
+    lt_class *t = static_cast<lt_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_eq: {
+    eq_class *t = static_cast<eq_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_leq: {
+    leq_class *t = static_cast<leq_class *>(n);
+    walk_tree(t->e1, f);
+    walk_tree(t->e2, f);
+    break;
+  }
+  case NODE_comp: {
+    comp_class *t = static_cast<comp_class *>(n);
+    walk_tree(t->e1, f);
+    break;
+  }
+  case NODE_isvoid: {
+    isvoid_class *t = static_cast<isvoid_class *>(n);
+    walk_tree(t->e1, f);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+#endif
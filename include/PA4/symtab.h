@@ -14,7 +14,12 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
+#include <assert.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 #include "list.h"
+#include "stats.h"
 
 //
 // SymtabEnty<SYM,DAT> defines the entry for a symbol table that associates
@@ -27,6 +32,7 @@ private:
   SYM id;        // the key field
   DAT info;     // associated information for the symbol
 public:
+  ARENA_ALLOCATED   // entries live in the compilation arena
   SymtabEntry(SYM x, DAT y) : id(x), info(y) { }
   SYM get_id() const    { return id; }
   DAT get_info() const { return info; }
@@ -34,91 +40,198 @@ public:
 
 //
 // SymbolTable<SYM,DAT> describes a symbol table mapping symbols of
-//    type `SYM' to data of type `DAT *'.  It is implemented as a
-//    list of lists of `SymtabEntry<SYM,DAT> *'.  The inner list is
-//    a scope, a mapping from symbols to data, and the outer list is
-//    a list of scopes. 
+//    type `SYM' to data of type `DAT'.  It is implemented as a log
+//    of the scopes entered and the bindings made in them
+//    (`SymtabEntry<SYM,DAT> *'), in order, plus a hash map from each
+//    symbol to the slots of the log binding it, innermost last; a
+//    scope is undone when it is exited by cutting the log back to
+//    where it started.
 //
-//    `tbl' points to the current top scope.
+//    `enterscope' opens a new scope inside the current one.
 //
-//    `enterscope' makes the table point to a new scope whose parent
-//       is the scope it pointed to previously.
-//
-//    `exitscope' makes the table point to the parent scope of the
-//        current scope.  Note that the old child scope is not
-//        deallocated.  One may save the state of a symbol table
-//        at a given point by copying it with `operator ='
+//    `exitscope' closes the current scope, popping the bindings made
+//        in it.
 //
 //    `addid(s,i)' adds a symbol table entry to the current scope of
-//        the symbol table mapping symbol `s' to data `d'.  The old
-//        top scope isn't modified; a new scope is created whose
-//        entry list is the new entry followed by the old entry list,
-//        and whose tail is the old top scope's parent.  The table
-//        is made to point to this new scope.
+//        the symbol table mapping symbol `s' to data `d', hiding any
+//        binding of `s' in an enclosing scope.
+//
+//    `lookup(s)' returns the data item of the innermost binding of
+//        `s', or NULL if no such entry exists.
+//
+//    `probe(s)' returns the data item of the binding of `s' in the
+//        current scope, and NULL if there is none.
+//
+//    `dump()' prints the symbols in the symbol table, innermost
+//        scope first.
 //
-//    `lookup(s)' looks for the symbol `s', starting at the top scope
-//        and proceeding down the list of scopes until either an
-//        entry is found whose `get_id()' equals `s', or the end of
-//        the root scope is reached.  It returns the data item
-//        associated with the entry, or NULL if no such entry exists.
+//    Exiting a scope, adding a symbol or probing for one when no scope
+//    is open is a bug in the caller, which an assertion catches.
 //
-//    
-//    `probe(s)' checks the top scope for an entry whose `get_id()'
-//        equals `s', and returns the entry's `get_info()' if
-//        found, and NULL otherwise.
+//    One may save the state of a symbol table at a given point by
+//    copying it with `operator =' (or the copy constructor).  The
+//    copies share one log of scopes and bindings, each seeing a prefix
+//    of it: a table changed at the end of the log appends to it, and the
+//    log is cut back to where the table seeing furthest stops.  Only
+//    when two copies are both changed after they part does one of them
+//    take a log of its own, copying the part it sees.
 //
-//    `dump()' prints the symbols in the symbol table.
+//    Copying a table, `enterscope', `exitscope' and `addid' take
+//    constant (amortized) time, except for that copy of the log, which
+//    takes time linear in the part copied.  `lookup' and `probe' take
+//    constant time, or time logarithmic in the number of bindings of
+//    the symbol when another table sharing the log has grown past this
+//    one.
 //
 
 template <class SYM, class DAT>
 class SymbolTable
 {
    typedef SymtabEntry<SYM,DAT> ScopeEntry;
-   typedef List<ScopeEntry> Scope;
-   typedef List<Scope> ScopeList;
+   // A slot of the log: a binding, or (entry NULL) the start of a scope.
+   struct Slot {
+      ScopeEntry *entry;
+      size_t outer;             // for a scope, the slot of the enclosing one
+   };
+   struct Rep {
+      std::vector<Slot> log;
+      // the slots binding each symbol, in order
+      std::unordered_map<SYM, std::vector<size_t> > bindings;
+      // seen[k] is the number of the tables sharing the log that see
+      // log[0..k); the log ends where the furthest one stops
+      std::vector<unsigned> seen;
+      int tables;
+      Rep(): seen(1, 0), tables(0) { }
+   };
+   static const size_t NONE = (size_t) -1;
 private:
-   ScopeList  *tbl;
+   Rep *rep;
+   size_t top;                  // this table sees log[0..top)
+   size_t scope;                // the slot of its innermost scope, or NONE
+   int depth;                   // the number of open scopes
+
+   void attach(Rep *r, size_t t)
+   {
+      rep = r;
+      top = t;
+      r->seen[t]++;
+      r->tables++;
+   }
+
+   void detach()
+   {
+      rep->seen[top]--;
+      if (--rep->tables == 0)
+	 delete rep;
+      else
+	 trim();
+   }
+
+   void move_top(size_t t)
+   {
+      rep->seen[top]--;
+      rep->seen[t]++;
+      top = t;
+   }
+
+   // Drop the slots at the end of the log that no table sees.
+   void trim()
+   {
+      while (rep->seen.back() == 0) {
+	 ScopeEntry *e = rep->log.back().entry;
+	 if (e) rep->bindings[e->get_id()].pop_back();
+	 rep->log.pop_back();
+	 rep->seen.pop_back();
+      }
+   }
+
+   // Add slot s to what this table sees.  If the log goes on past top,
+   // another table sees further, so this one parts from the others and
+   // takes a copy of its prefix.
+   void extend(Slot s)
+   {
+      if (top < rep->log.size()) {
+	 Rep *r = new Rep();
+	 r->log.assign(rep->log.begin(), rep->log.begin() + top);
+	 r->seen.resize(top + 1);
+	 for (size_t j = 0; j < top; j++)
+	    if (r->log[j].entry)
+	       r->bindings[r->log[j].entry->get_id()].push_back(j);
+	 size_t t = top;
+	 detach();
+	 attach(r, t);
+      }
+      rep->log.push_back(s);
+      rep->seen.push_back(0);
+      if (s.entry) rep->bindings[s.entry->get_id()].push_back(top);
+      move_top(top + 1);
+   }
+
+   // The slot of the innermost binding of s this table sees, or NONE.
+   size_t find(SYM s) const
+   {
+      stat_counters.symtab_lookups++;
+      typename std::unordered_map<SYM, std::vector<size_t> >::const_iterator
+	  i = rep->bindings.find(s);
+      if (i == rep->bindings.end() || i->second.empty())
+	  return NONE;
+      const std::vector<size_t> &slots = i->second;
+      if (slots.back() < top)
+	  return slots.back();
+      std::vector<size_t>::const_iterator j =
+	  std::lower_bound(slots.begin(), slots.end(), top);
+      return j == slots.begin() ? NONE : *(j - 1);
+   }
 public:
-   SymbolTable(): tbl(NULL) { }     // create a new symbol table
+   // create a new symbol table
+   SymbolTable(): scope(NONE), depth(0) { attach(new Rep(), 0); }
+   SymbolTable(const SymbolTable &s): scope(s.scope), depth(s.depth)
+   {
+      attach(s.rep, s.top);
+   }
+   ~SymbolTable() { detach(); }
 
    // Create pointer to current symbol table.
-   SymbolTable &operator =(const SymbolTable &s) { tbl = s.tbl; return *this; }
-
-   void fatal_error(char * msg)
+   SymbolTable &operator =(const SymbolTable &s)
    {
-     cerr << msg << "\n";
-     exit(1);
-   } 
+      if (this != &s) {
+	 detach();
+	 attach(s.rep, s.top);
+	 scope = s.scope;
+	 depth = s.depth;
+      }
+      return *this;
+   }
 
-   // Enter a new scope.  A symbol table is organized as a list of
-   // lists.  The head of the list is the innermost scope, the tail
-   // holds the outer scopes.  A scope must be entered before anything
-   // can be added to the table.
+   // Enter a new scope.  A scope must be entered before anything can
+   // be added to the table.
 
    void enterscope()
    {
-       // The cast of NULL is required for template instantiation to work
-       // correctly.
-       tbl = new ScopeList((Scope *) NULL, tbl);
+       Slot s = { NULL, scope };
+       scope = top;
+       extend(s);
+       depth++;
    }
 
-   // Pop the first scope off of the symbol table.
+   // Pop the first scope off of the symbol table, removing its bindings.
    void exitscope()
    {
-       // It is an error to exit a scope that doesn't exist.
-       if (tbl == NULL) {
-	   fatal_error("exitscope: Can't remove scope from an empty symbol table.");
-       }
-       tbl = tbl->tl();
+       assert(depth > 0);
+       size_t t = scope;
+       scope = rep->log[t].outer;
+       depth--;
+       move_top(t);
+       trim();
    }
 
    // Add an item to the symbol table.
    ScopeEntry *addid(SYM s, DAT i)
    {
-       // There must be at least one scope to add a symbol.
-       if (tbl == NULL) fatal_error("addid: Can't add a symbol without a scope.");
+       assert(scope != NONE);
        ScopeEntry * se = new ScopeEntry(s,i);
-       tbl = new ScopeList(new Scope(se, tbl->hd()), tbl->tl());
+       Slot b = { se, NONE };
+       extend(b);
        return(se);
    }
    
@@ -128,39 +241,31 @@ public:
 
    DAT lookup(SYM s)
    {
-       for(ScopeList *i = tbl; i != NULL; i=i->tl()) {
-	   for( Scope *j = i->hd(); j != NULL; j = j->tl()) {
-	       if (s == j->hd()->get_id()) {
-		   return (j->hd()->get_info());
-	       }
-	   }
-       }
-       return NULL;
+       size_t j = find(s);
+       return j == NONE ? NULL : rep->log[j].entry->get_info();
    }
 
    // probe the symbol table.  Check the top scope (only) for the item
    // 's'.  If found, return the information field.  If not return NULL.
    DAT probe(SYM s)
    {
-       if (tbl == NULL) {
-	   fatal_error("probe: No scope in symbol table.");
-       }
-       for(Scope *i = tbl->hd(); i != NULL; i = i->tl()) {
-	   if (s == i->hd()->get_id()) {
-	       return(i->hd()->get_info());
-	   }
-       }
-       return(NULL);
+       assert(scope != NONE);
+       size_t j = find(s);
+       if (j == NONE || j < scope)
+	   return NULL;
+       return rep->log[j].entry->get_info();
    }
 
    // Prints out the contents of the symbol table  
    void dump()
    {
-      for(ScopeList *i = tbl; i != NULL; i = i->tl()) {
+      size_t end = top;
+      for(size_t k = scope; k != NONE; k = rep->log[k].outer) {
          cerr << "\nScope: \n";
-         for(Scope *j = i->hd(); j != NULL; j = j->tl()) {
-            cerr << "  " << j->hd()->get_id() << endl;
+         for(size_t j = end; j > k + 1; j--) {
+            cerr << "  " << rep->log[j-1].entry->get_id() << endl;
          }
+         end = k;
       }
    }
  
@@ -0,0 +1,98 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  arena.h
+//
+//  A bump allocator for the objects that live as long as a compilation:
+//  AST nodes (tree_node), string table entries (Entry) and their string
+//  bytes, List<T> cells and symbol table entries (SymtabEntry).  These
+//  classes allocate from compilation_arena through their own operator
+//  new; their operator delete does nothing.  Instead, release() frees
+//  every block at once when the compilation is over.  Destructors of
+//  arena objects are never run, and nothing allocated before a release
+//  may be used after it (the string tables must be cleared first).
+//
+//  Option -m reports the arena's size and high-water marks on release.
+//
+//  compilation_arena is per thread.  It starts out as the default arena
+//  on every thread; a thread doing a share of the work (see the front
+//  end in coolc.cc) points it at an arena of its own, which must not be
+//  released before the objects allocated from it are done with.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include "cool-io.h"
+
+extern int arena_debug;         // report arena usage on release
+
+class Arena {
+private:
+  struct Block {
+    Block *next;                // the block allocated before this one
+    size_t size;                // bytes of data following the header
+  };
+  Block *blocks;                // the current block, then older ones
+  char *next_free;              // next free byte in the current block
+  char *limit;                  // end of the current block
+  size_t in_use;                // bytes handed out since the last release
+  size_t reserved;              // bytes of data in all blocks
+  size_t high_water;            // largest in_use at any release
+  size_t high_reserved;         // largest reserved at any release
+  long num_allocs;              // allocations since the last release
+  int num_blocks;
+
+  void *allocate_block(size_t n);
+public:
+  // constexpr, so that the default arena is ready before any static
+  // initializer allocates from it
+  constexpr Arena()
+    : blocks(NULL), next_free(NULL), limit(NULL), in_use(0), reserved(0),
+      high_water(0), high_reserved(0), num_allocs(0), num_blocks(0) { }
+  ~Arena();
+
+  // n bytes, suitably aligned for any object
+  void *allocate(size_t n)
+  {
+    n = (n + ALIGN - 1) & ~(size_t) (ALIGN - 1);
+    num_allocs++;
+    in_use += n;
+    if ((size_t) (limit - next_free) < n)
+      return allocate_block(n);
+    void *p = next_free;
+    next_free += n;
+    return p;
+  }
+
+  // a null terminated copy of the first len characters of s
+  char *copy_string(const char *s, int len);
+
+  // free everything allocated so far
+  void release();
+
+  size_t bytes_in_use() const    { return in_use; }
+  size_t high_water_mark() const { return in_use > high_water ? in_use : high_water; }
+  void print_stats(ostream& s) const;
+
+  static const size_t ALIGN = 2 * sizeof(void *);
+  static const size_t BLOCK_SIZE = 64 * 1024;
+};
+
+extern thread_local Arena *compilation_arena;
+
+//
+// Declarations giving a class arena allocation; used inside the class.
+//
+#define ARENA_ALLOCATED                                                 \
+  static void *operator new(size_t n) { return compilation_arena->allocate(n); } \
+  static void operator delete(void *) { }
+
+#endif
@@ -0,0 +1,63 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+//////////////////////////////////////////////////////////////////////
+//
+//  stats.h
+//
+//  Compile-time statistics, for keeping an eye on where the time and
+//  memory of a compilation go.  Option -P text (or -P json) reports at
+//  exit, on stderr:
+//
+//    - for each phase the driver brackets with begin_phase/end_phase,
+//      its wall time, its CPU time (of all threads) and the peak
+//      resident set size of the process at its end;
+//    - the counters below, summed over all threads;
+//    - the size of each string table and the searches and bucket probes
+//      made in it;
+//    - the instructions emitted for each method bracketed with
+//      begin_method/end_method.
+//
+//  The counters are per thread and always kept.  A thread doing a share
+//  of the work (see the front end in coolc.cc) adds its counts to the
+//  totals with merge_counters() before it finishes.  The phases and
+//  methods are per thread as well: a thread reports those it bracketed.
+//
+//////////////////////////////////////////////////////////////////////
+
+enum StatsFormat { STATS_NONE, STATS_TEXT, STATS_JSON };
+
+extern int stats_format;        // what -P asked for; STATS_NONE without it
+
+struct StatCounters {
+  long tokens;                  // tokens read by the parser or lextest
+  long tree_nodes;              // tree nodes constructed
+  long symtab_lookups;          // SymbolTable lookups and probes
+  long semant_errors;           // errors reported by semantic analysis
+  long semant_cached;           // classes semant took from its cache (-C)
+  long instructions;            // instructions emitted by cgen
+};
+
+extern thread_local StatCounters stat_counters;
+
+void merge_counters();
+
+// Phases do not nest; beginning a phase ends the current one.
+void begin_phase(const char *name);
+void end_phase();
+
+void begin_method(char *class_name, char *method_name);
+void end_method();
+
+// Write the report now (if -P was given) rather than at exit; it is
+// written only once.  Used when the string tables are about to be
+// cleared.
+void print_stats();
+
+#endif
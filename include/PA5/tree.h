@@ -16,6 +16,7 @@
  
 
 #include "stringtab.h"
+#include "arena.h"
 #include "cool-io.h"
 
 /////////////////////////////////////////////////////////////////////
@@ -27,6 +28,8 @@
 //       int line_number     line in the source file from which this node came;
 //                           this is read from a global variable when the
 //                           node is created.
+//       unsigned char kind  which constructor built the node (a NodeKind,
+//                           see cool-tree.handcode.h); 0 for lists.
 //      
 //
 //
@@ -41,6 +44,7 @@
 //         the number of spaces to indent the output.
 //
 //       int get_line_number();  return the line number
+//       int get_kind() const;   return the kind
 //       Symbol get_type();      return the type 
 //
 //       tree_node *set(tree_node *t)
@@ -52,12 +56,15 @@
 class tree_node {
 protected:
     int line_number;            // stash the line number when node is made
+    unsigned char kind;         // set by the constructors of cool-tree.h
 public:
+    ARENA_ALLOCATED             // nodes live in the compilation arena
     tree_node();
     virtual tree_node *copy() = 0;
     virtual ~tree_node() { }
     virtual void dump(ostream& stream, int n) = 0;
     int get_line_number();
+    int get_kind() const { return kind; }
     tree_node *set(tree_node *);
 };
 
@@ -95,8 +102,15 @@ public:
 //
 //     nth_length(int n, int &len);
 //     Returns the nth element of the list or NULL if there are not n elements.
-//     "len" is set to the length of the list.  This method is used internally
-//     by the APS package to efficiently traverse the list representation.  
+//     "len" is set to the length of the list.
+//
+//     Elem *begin();
+//     Elem *end();
+//     The elements are stored contiguously, so a list can also be
+//     walked with a range-based for:
+//
+//     for (Elem e : *l)
+//         ... operate on e ...
 //
 //     static list_node<Elem> *nil();
 //     static list_node<Elem> *single(Elem);
@@ -110,9 +124,47 @@ public:
 //     list_node<Elem>::single(e);     where "e" has type Elem
 //     list_node<Elem>::append(l1,l2);
 //
+//     nth, len, first, next and more take constant time.
+//
+//  A list is a window [start, start+size) onto an array of elements
+//  (a list_buffer) that may be shared with other lists.  Lists are never
+//  modified once built, so append may extend a buffer in place when one
+//  of its arguments reaches the end of the buffer's used part in the
+//  direction it grows: append(l, single(e)) then stores e just after l's
+//  elements, and building a list by repeated appends takes amortized
+//  constant time per element.  Other lists on the same buffer still see
+//  only their own window.  When neither argument can be extended, the
+//  elements of both are copied into a new buffer.
+//
+//  nil_node, single_list_node and append_node construct the three kinds
+//  of list.  They differ only in how dump prints them, which remains as
+//  it was when append built a tree of nodes.
+//
 //////////////////////////////////////////////////////////////////////////////
 
+template <class Elem> struct list_buffer {
+    ARENA_ALLOCATED
+    Elem *elems;     // elems[origin + i] holds element i
+    int origin;
+    int lo, hi;      // elements [lo, hi) are in use
+    int cap;         // allocated length of elems
+};
+
 template <class Elem> class list_node : public tree_node {
+protected:
+    enum list_shape { NIL, SINGLE, APPEND };
+
+    list_buffer<Elem> *buf;   // NULL for a list that has never had elements
+    int start;                // index of the first element in buf
+    int size;                 // number of elements
+    list_shape shape;         // how the list was built; only dump cares
+
+    list_node();
+    list_node(Elem e);
+    list_node(list_node<Elem> *l1, list_node<Elem> *l2);
+    list_node(list_node<Elem> *l, list_shape s);
+
+    void reserve(int front, int back);
 public:
     tree_node *copy()            { return copy_list(); }
     Elem nth(int n);
@@ -121,12 +173,15 @@ public:
     //
     int first()      { return 0; }
     int next(int n)  { return n + 1; }
-    int more(int n)  { return (n < len()); }
+    int more(int n)  { return (n < size); }
 
-    virtual list_node<Elem> *copy_list() = 0;
-    virtual ~list_node() { }
-    virtual int len() = 0;
-    virtual Elem nth_length(int n, int &len) = 0;
+    Elem *begin()    { return buf ? buf->elems + buf->origin + start : NULL; }
+    Elem *end()      { return begin() + size; }
+
+    list_node<Elem> *copy_list();
+    int len()        { return size; }
+    Elem nth_length(int n, int &len);
+    void dump(ostream& stream, int n);
 
     static list_node<Elem> *nil();
     static list_node<Elem> *single(Elem);
@@ -139,38 +194,19 @@ extern int info_size;
 
 template <class Elem> class nil_node : public list_node<Elem> {
 public:
-    list_node<Elem> *copy_list();
-    int len();
-    Elem nth_length(int n, int &len);
-    void dump(ostream& stream, int n);
+    nil_node() { }
 };
 
 template <class Elem> class single_list_node : public list_node<Elem> {
-    Elem elem;
 public:
-    single_list_node(Elem t) {
-	elem = t;
-    }
-    list_node<Elem> *copy_list();
-    int len();
-    Elem nth_length(int n, int &len);
-    void dump(ostream& stream, int n);
+    single_list_node(Elem t) : list_node<Elem>(t) { }
 };
 
 
 template <class Elem> class append_node : public list_node<Elem> {
-private:
-    list_node<Elem> *some, *rest;
 public:
-    append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
-	some = l1;
-	rest = l2;
-    }
-    list_node<Elem> *copy_list();
-    int len();
-    Elem nth(int n);
-    Elem nth_length(int n, int &len);
-    void dump(ostream& stream, int n);
+    append_node(list_node<Elem> *l1, list_node<Elem> *l2)
+	: list_node<Elem>(l1, l2) { }
 };
 
 
@@ -188,211 +224,182 @@ template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// list_node::nth
+// list_node::list_node
 //
-// function to find the nth element of the list
+// the constructors for the empty list, a list of one element, the
+// append of two lists, and a list with the same elements as l
 //
 ///////////////////////////////////////////////////////////////////////////
-
-template <class Elem> Elem list_node<Elem>::nth(int n)
+template <class Elem> list_node<Elem>::list_node()
+    : buf(NULL), start(0), size(0), shape(NIL)
 {
-    int len;
-    Elem tmp = nth_length(n ,len);
-
-    if (tmp)
-	return tmp;
-    else {
-	cerr << "error: outside the range of the list\n";
-	exit(1);
-    }
 }
 
-// added 10/30/06 cgs
-template <class Elem> Elem append_node<Elem>::nth(int n)
+template <class Elem> list_node<Elem>::list_node(Elem e)
+    : buf(new list_buffer<Elem>), start(0), size(1), shape(SINGLE)
 {
-    int len;
-    Elem tmp = nth_length(n ,len);
-
-    if (tmp)
-	return tmp;
-    else {
-	cerr << "error: outside the range of the list\n";
-	exit(1);
-    }
+    buf->cap = 4;
+    buf->elems = (Elem *) compilation_arena->allocate(buf->cap * sizeof(Elem));
+    buf->origin = 0;
+    buf->lo = 0;
+    buf->hi = 1;
+    buf->elems[0] = e;
 }
 
-///////////////////////////////////////////////////////////////////////////
-//
-// nil_node::copy_list
-//
-// return the deep copy of the nil_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> list_node<Elem> *nil_node<Elem>::copy_list()
+template <class Elem> list_node<Elem>::list_node(list_node<Elem> *l, list_shape s)
+    : buf(l->buf), start(l->start), size(l->size), shape(s)
 {
-    return new nil_node<Elem>();
 }
 
-
-///////////////////////////////////////////////////////////////////////////
-//
-// nil_node::len
-//
-// return the length of the nil_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> int nil_node<Elem>::len()
+template <class Elem>
+list_node<Elem>::list_node(list_node<Elem> *l1, list_node<Elem> *l2)
+    : shape(APPEND)
 {
-    return 0;
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// nil_node::nth_length
-//
-// return the nth element on the list
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem nil_node<Elem>::nth_length(int, int &len)
-{
-    len = 0;
-    return NULL;
+    int n1 = l1->size, n2 = l2->size;
+    size = n1 + n2;
+    if (n2 == 0 || n1 == 0) {
+	list_node<Elem> *l = n2 == 0 ? l1 : l2;
+	buf = l->buf;
+	start = l->start;
+    } else if (l1->start + n1 == l1->buf->hi) {
+	// add l2's elements after l1's
+	buf = l1->buf;
+	start = l1->start;
+	reserve(0, n2);
+	Elem *from = l2->begin(), *to = begin() + n1;
+	for (int i = 0; i < n2; i++)
+	    to[i] = from[i];
+	buf->hi += n2;
+    } else if (l2->start == l2->buf->lo) {
+	// add l1's elements before l2's
+	buf = l2->buf;
+	start = l2->start - n1;
+	reserve(n1, 0);
+	Elem *from = l1->begin(), *to = begin();
+	for (int i = 0; i < n1; i++)
+	    to[i] = from[i];
+	buf->lo -= n1;
+    } else {
+	buf = new list_buffer<Elem>;
+	buf->cap = 2 * size;
+	buf->elems = (Elem *) compilation_arena->allocate(buf->cap * sizeof(Elem));
+	buf->origin = 0;
+	buf->lo = start = 0;
+	buf->hi = size;
+	Elem *to = buf->elems;
+	for (Elem e : *l1)
+	    *to++ = e;
+	for (Elem e : *l2)
+	    *to++ = e;
+    }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// nil_node::dump
+// list_node::reserve
 //
-// dump for list node
+// make room in the buffer for "front" more elements before those in use
+// and "back" more after them.  The buffer at least doubles when it
+// grows, and only leaves room on the side that is growing.
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> void nil_node<Elem>::dump(ostream& stream, int n)
+template <class Elem> void list_node<Elem>::reserve(int front, int back)
 {
-    stream << pad(n) << "(nil)\n";
+    int used = buf->hi - buf->lo;
+    if (buf->origin + buf->lo >= front && buf->cap - (buf->origin + buf->hi) >= back)
+	return;
+
+    int room_front = front ? front + used : 0;
+    int room_back = back ? back + used : 0;
+    int cap = room_front + used + room_back;
+    Elem *elems = (Elem *) compilation_arena->allocate(cap * sizeof(Elem));
+    Elem *from = buf->elems + buf->origin + buf->lo;
+    for (int i = 0; i < used; i++)
+	elems[room_front + i] = from[i];
+    buf->elems = elems;
+    buf->cap = cap;
+    buf->origin = room_front - buf->lo;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// single_list_node::copy_list
+// list_node::nth
 //
-// return the deep copy of the single_list_node
+// function to find the nth element of the list
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> list_node<Elem> *single_list_node<Elem>::copy_list()
-{
-    return new single_list_node<Elem>((Elem) elem->copy());
-}
-
 
-///////////////////////////////////////////////////////////////////////////
-//
-// single_list_node::len
-//
-// return the length of the single_list_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> int single_list_node<Elem>::len()
+template <class Elem> Elem list_node<Elem>::nth(int n)
 {
-    return 1;
+    if (0 <= n && n < size)
+	return begin()[n];
+    else {
+	cerr << "error: outside the range of the list\n";
+	exit(1);
+    }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// single_list_node::nth_length
+// list_node::nth_length
 //
 // return the nth element on the list
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem single_list_node<Elem>::nth_length(int n, int &len)
+template <class Elem> Elem list_node<Elem>::nth_length(int n, int &len)
 {
-    len = 1;
-    if (n)
-	return NULL;
+    len = size;
+    if (0 <= n && n < size)
+	return begin()[n];
     else
-	return elem;
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// single_list_node::dump
-//
-// dump for list node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> void single_list_node<Elem>::dump(ostream& stream, int n)
-{
-    elem->dump(stream, n);
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// append_node::copy_list
-//
-// return the deep copy of the append_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
-{
-    return new append_node<Elem>(some->copy_list(), rest->copy_list());
+	return NULL;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// append_node::len
+// list_node::copy_list
 //
-// return the length of the append_node
+// return the deep copy of the list, built the same way
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> int append_node<Elem>::len()
+template <class Elem> list_node<Elem> *list_node<Elem>::copy_list()
 {
-    return some->len() + rest->len();
+    list_node<Elem> *l = nil();
+    for (Elem e : *this)
+	l = append(l, single((Elem) e->copy()));
+    return new list_node<Elem>(l, shape);
 }
 
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// append_node::nth_length
+// list_node::dump
 //
-// return the nth element on the list
+// dump for list node: a nil list prints as "(nil)", a single element
+// list as the element, and any appended list as all of its elements
+// between "list" and "(end_of_list)"
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem append_node<Elem>::nth_length(int n, int &len)
+template <class Elem> void list_node<Elem>::dump(ostream& stream, int n)
 {
-    int rlen;
-    Elem tmp = some->nth_length(n, len);
-
-    if (!tmp) {
-	tmp = rest->nth_length(n-len, rlen);
-	len += rlen;
+    switch (shape) {
+    case NIL:
+	stream << pad(n) << "(nil)\n";
+	break;
+    case SINGLE:
+	nth(0)->dump(stream, n);
+	break;
+    case APPEND:
+	stream << pad(n) << "list\n";
+	for (Elem e : *this)
+	    e->dump(stream, n+2);
+	stream << pad(n) << "(end_of_list)\n";
+	break;
     }
-    return tmp;
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// append_node::dump
-//
-// dump for list node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> void append_node<Elem>::dump(ostream& stream, int n)
-{
-    int i, size;
-
-    size = len();
-    stream << pad(n) << "list\n";
-    for (i = 0; i < size; i++)
-      nth(i)->dump(stream, n+2);
-    stream << pad(n) << "(end_of_list)\n";
 }
 
 
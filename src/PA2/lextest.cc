@@ -10,7 +10,8 @@
 //
 //  Reads input from file argument.
 //
-//  Option -l prints summary of flex actions.
+//  Option -l prints summary of flex actions.  Option -P reports the time
+//  spent lexing and the number of tokens.
 //
 //////////////////////////////////////////////////////////////////////////////
 
@@ -18,21 +19,24 @@
 #include <unistd.h>     // for getopt
 #include "cool-parse.h" // bison-generated file; defines tokens
 #include "utilities.h"
+#include "stats.h"
 
 //
 //  The lexer keeps this global variable up to date with the line number
-//  of the current line read from the input.
+//  of the current line read from the input.  The lexer's globals are
+//  per thread (coolc runs several lexers at once).
 //
-int curr_lineno = 1;
-char *curr_filename = "<stdin>"; // this name is arbitrary
-FILE *fin;   // This is the file pointer from which the lexer reads its input.
+thread_local int curr_lineno = 1;
+thread_local char *curr_filename = "<stdin>"; // this name is arbitrary
+thread_local FILE *fin;   // This is the file pointer from which the lexer reads its input.
 
 //
 //  cool_yylex() is the function produced by flex. It returns the next
 //  token each time it is called.
 //
 extern int cool_yylex();
-YYSTYPE cool_yylval;           // Not compiled with parser, so must define this.
+extern void cool_scan_file(FILE *);  // point the lexer at a new file
+thread_local YYSTYPE cool_yylval; // Not compiled with parser, so must define this.
 
 extern int optind;  // used for option processing (man 3 getopt for more info)
 
@@ -62,12 +66,14 @@ int main(int argc, char** argv) {
 	
 	handle_flags(argc,argv);
 
+	begin_phase("lex");
 	while (optind < argc) {
 	    fin = fopen(argv[optind], "r");
 	    if (fin == NULL) {
 		cerr << "Could not open input file " << argv[optind] << endl;
 		exit(1);
 	    }
+	    cool_scan_file(fin);
 
             // sm: the 'coolc' compiler's file-handling loop resets
             // this counter, so let's make the stand-alone lexer
@@ -80,6 +86,7 @@ int main(int argc, char** argv) {
 	    cout << "#name \"" << argv[optind] << "\"" << endl;
 	    while ((token = cool_yylex()) != 0) {
 		dump_cool_token(cout, curr_lineno, token, cool_yylval);
+		stat_counters.tokens++;
 	    }
 	    fclose(fin);
 	    optind++;
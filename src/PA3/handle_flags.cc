@@ -6,34 +6,55 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "cool-io.h"
 #include <unistd.h>
 #include "cgen_gc.h"
+#include "stats.h"
 
 //
 // coolc provides a debugging switch for each phase of the compiler,
-// switches to control garbage collection policy, and a switch to enable 
-// optimization.  The optimization flag is ignored by the reference compiler.
+// switches to control garbage collection policy, and switches to enable
+// optimization (-O), to leave some of its passes out (-X, see
+// optimize.h) and to generate code through the IR (-I, see ir.h).  The reference compiler ignores them.
 //
 // All flags that can be set on the command line should be defined here;
 // otherwise, it is necessary to pollute test drivers for components of the
 // compiler with declarations of extern'ed debugging flags to satisfy the
 // linker.  The exceptions to this rule are yy_flex_debug and cool_yydebug, 
-// which are defined in files generated by flex and bison.
+// which are defined in files generated by flex and bison, arena_debug,
+// which is defined with the arena in arena.cc, and stats_format, which is
+// defined with the statistics in stats.cc.
 //
 
 extern int yy_flex_debug;       // for the lexer; prints recognized rules
 extern int cool_yydebug;        // for the parser
+extern int arena_debug;         // report memory used by the arena
+extern int stats_format;        // report phase times and counters
        int lex_verbose;         // also for the lexer; prints tokens
-       int semant_debug;        // for semantic analysis
-       int cgen_debug;          // for code gen
-       bool disable_reg_alloc;  // Don't do register allocation
-
-       int cgen_optimize;       // optimize switch for code generator 
+       int ast_verbose;         // dump the AST between phases of coolc
+       int ast_binary;          // write the AST in binary format
+       int front_end_jobs;      // threads lexing and parsing in coolc (-j)
        char *out_filename;      // file name for generated code
-       Memmgr cgen_Memmgr = GC_NOGC;      // enable/disable garbage collection
-       Memmgr_Test cgen_Memmgr_Test = GC_NORMAL;  // normal/test GC
-       Memmgr_Debug cgen_Memmgr_Debug = GC_QUICK; // check heap frequently
+
+//
+// The flags for semantic analysis and code generation are per thread, so
+// that compilations running on different threads can differ in them (see
+// CompilerContext in libcoolc.h).  handle_flags sets them for the thread
+// that calls it.
+//
+thread_local int semant_debug;        // for semantic analysis
+thread_local int semant_jobs = 1;     // threads type checking classes
+thread_local char *semant_cache_dir;  // semant's per-class results; NULL for none
+thread_local int cgen_debug;          // for code gen
+thread_local bool disable_reg_alloc;  // Don't do register allocation
+thread_local bool cgen_use_ir;        // generate code through the IR
+
+thread_local int cgen_optimize;       // optimize switch for code generator 
+thread_local char *cgen_skip_passes;  // passes -O leaves out; NULL for none
+thread_local Memmgr cgen_Memmgr = GC_NOGC;      // enable/disable garbage collection
+thread_local Memmgr_Test cgen_Memmgr_Test = GC_NORMAL;  // normal/test GC
+thread_local Memmgr_Debug cgen_Memmgr_Debug = GC_QUICK; // check heap frequently
 
 // used for option processing (man 3 getopt for more info)
 extern int optind, opterr;
@@ -46,14 +67,22 @@ void handle_flags(int argc, char *argv[]) {
   // no debugging or optimization by default
   yy_flex_debug = 0;
   cool_yydebug = 0;
+  arena_debug = 0;
   lex_verbose  = 0;
+  ast_verbose  = 0;
+  ast_binary   = 0;
+  front_end_jobs = 0;           // one per processor
+  stats_format = STATS_NONE;
   semant_debug = 0;
+  semant_cache_dir = NULL;
   cgen_debug = 0;
   cgen_optimize = 0;
+  cgen_skip_passes = NULL;
   disable_reg_alloc = 0;
+  cgen_use_ir = 0;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lpscvramOIbo:gtTj:P:C:X:")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -74,6 +103,12 @@ void handle_flags(int argc, char *argv[]) {
     case 'r':
       disable_reg_alloc = 1;
       break;
+    case 'a':
+      ast_verbose = 1;
+      break;
+    case 'm':
+      arena_debug = 1;
+      break;
 #else
     case 'l':
     case 'p':
@@ -81,6 +116,8 @@ void handle_flags(int argc, char *argv[]) {
     case 'c': 
     case 'v':
     case 'r':
+    case 'a':
+    case 'm':
       cerr << "No debugging available\n";
       break;
 #endif
@@ -99,6 +136,29 @@ void handle_flags(int argc, char *argv[]) {
     case 'O':  // enable optimization
       cgen_optimize = 1;
       break;
+    case 'I':  // generate code through the intermediate representation
+      cgen_use_ir = 1;
+      break;
+    case 'X':  // optimization passes to leave out, separated by commas
+      cgen_skip_passes = optarg;
+      break;
+    case 'b':  // exchange the AST between phases in binary
+      ast_binary = 1;
+      break;
+    case 'j':  // number of threads for the front end (parse and semant)
+      front_end_jobs = atoi(optarg);
+      break;
+    case 'C':  // keep semant's results per class in this directory
+      semant_cache_dir = optarg;
+      break;
+    case 'P':  // report where the time and memory went, as text or JSON
+      if (strcmp(optarg, "text") == 0)
+        stats_format = STATS_TEXT;
+      else if (strcmp(optarg, "json") == 0)
+        stats_format = STATS_JSON;
+      else
+        unknownopt = 1;
+      break;
     case '?':
       unknownopt = 1;
       break;
@@ -111,11 +171,15 @@ void handle_flags(int argc, char *argv[]) {
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvpscOIgtTramb -o outname -j jobs -P text|json -C cachedir -X passes] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-OIgtTb -o outname -j jobs -P text|json -C cachedir -X passes] [input-files]\n";
 #endif
       exit(1);
   }
 
+  semant_jobs = front_end_jobs;
+
+  if (stats_format != STATS_NONE)
+    atexit(print_stats);
 }
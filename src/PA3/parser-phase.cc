@@ -16,31 +16,40 @@
 #include <unistd.h>    // for getopt
 #include "cool-io.h"  //includes iostream
 #include "cool-tree.h"
-#include "utilities.h"  // for fatal_error
+#include "utilities.h"
 #include "cool-parse.h"
+#include "ast-binary.h"
+#include "stats.h"
 
 //
 // These globals keep everything working.
 //
 FILE *token_file = stdin;		// we read from this file
-extern Classes parse_results;	 // list of classes; used for multiple files 
-extern Program ast_root;	 // the AST produced by the parse
+extern thread_local Classes parse_results; // list of classes; used for multiple files 
+extern thread_local Program ast_root;	 // the AST produced by the parse
 
-char *curr_filename = "<stdin>";
+thread_local char *curr_filename = "<stdin>";
 
-extern int omerrs;             // a count of lex and parse errors
+extern thread_local int omerrs;    // a count of lex and parse errors
+extern int ast_binary;         // write the AST in binary format
 
 extern int cool_yyparse();
 void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
     handle_flags(argc, argv);
+    begin_phase("parse");
     cool_yyparse();
+    end_phase();
     if (omerrs != 0) {
 	cerr << "Compilation halted due to lex and parse errors\n";
 	exit(1);
     }
-    ast_root->dump_with_types(cout,0);
+    begin_phase("dump");
+    if (ast_binary)
+	dump_ast_binary(cout, ast_root);
+    else
+	ast_root->dump_with_types(cout,0);
     return 0;
 }
 
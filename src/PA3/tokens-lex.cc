@@ -722,8 +722,8 @@ char *string_buf_ptr;
 
 extern int verbose_flag;
 //changed
-extern int curr_lineno;
-extern char* curr_filename;
+extern thread_local int curr_lineno;
+extern thread_local char* curr_filename;
 
 static int prevstate;
 
@@ -0,0 +1,129 @@
+//
+// lca_bench.cc
+//
+// Times ClassTable::lowest_common_ancestor on synthetic hierarchies:
+//
+//    wide   every class inherits from one of the classes before it,
+//           chosen at random (a bushy tree of small depth);
+//    deep   one chain, each class inheriting from the one before.
+//
+// For each, random pairs and random 8-way sets are joined, and a sample
+// of the pairs is checked against a walk up the parent chains.
+//
+//    lca_bench [classes] [queries]   (defaults 10000 and 1000000)
+//
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include "semant.h"
+
+thread_local char *curr_filename = "<lca_bench>";
+FILE *ast_file;       // not used, but needed to link with the AST reader
+int cool_yydebug;     // not used, but needed to link with handle_flags
+
+static double seconds(clock_t start)
+{
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+static Symbol class_name(int i)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "C%d", i);
+  return idtable.add_string(buf);
+}
+
+//
+// Classes C0 .. C(n-1); parent[i] is the number of Ci's parent, or -1
+// for Object.
+//
+static Classes make_classes(const std::vector<int>& parent)
+{
+  Symbol filename = stringtable.add_string("<lca_bench>");
+  Symbol object = idtable.add_string("Object");
+  Classes classes = nil_Classes();
+  for (size_t i = 0; i < parent.size(); i++)
+    classes = append_Classes(classes,
+      single_Classes(class_(class_name(i),
+                            parent[i] < 0 ? object : class_name(parent[i]),
+                            nil_Features(), filename)));
+  return classes;
+}
+
+//
+// The join found by walking up from a to the first ancestor of b.
+//
+static Symbol slow_join(ClassTable& t, Symbol a, Symbol b)
+{
+  std::unordered_set<Symbol> above_b;
+  for (Symbol c = b; ; c = t.sym_class.at(c)->get_parent_name()) {
+    above_b.insert(c);
+    if (t.registry.id(c) == 0)
+      break;
+  }
+  while (!above_b.count(a))
+    a = t.sym_class.at(a)->get_parent_name();
+  return a;
+}
+
+static int run(const char *name, const std::vector<int>& parent, int queries)
+{
+  int n = parent.size();
+  ClassTable t(make_classes(parent));
+  if (t.errors()) {
+    cerr << "lca_bench: bad hierarchy" << endl;
+    return 1;
+  }
+
+  std::vector<Symbol> names(n);
+  for (int i = 0; i < n; i++)
+    names[i] = class_name(i);
+
+  srand(1);
+  std::vector<Symbol> sets(8 * 1024);
+  for (size_t i = 0; i < sets.size(); i++)
+    sets[i] = names[rand() % n];
+
+  clock_t start = clock();
+  long sum = 0;         // keeps the joins from being optimized away
+  for (int q = 0; q < queries; q++) {
+    Symbol *p = &sets[(q * 2) % sets.size()];
+    sum += (long) t.lowest_common_ancestor(p[0], p[1]);
+  }
+  double pairs = seconds(start);
+
+  start = clock();
+  for (int q = 0; q < queries; q++)
+    sum += (long) t.lowest_common_ancestor(&sets[(q * 8) % sets.size()], 8);
+  double eights = seconds(start);
+
+  for (size_t i = 0; i + 1 < sets.size(); i += 16)
+    if (t.lowest_common_ancestor(sets[i], sets[i + 1]) !=
+        slow_join(t, sets[i], sets[i + 1])) {
+      cerr << "lca_bench: wrong join of " << sets[i] << " and "
+           << sets[i + 1] << endl;
+      return 1;
+    }
+
+  cout << name << " (" << n << " classes): "
+       << pairs * 1e9 / queries << " ns per pair, "
+       << eights * 1e9 / queries << " ns per 8-way join"
+       << (sum == 0 ? " " : "") << endl;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int n = argc > 1 ? atoi(argv[1]) : 10000;
+  int queries = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  std::vector<int> wide(n), deep(n);
+  srand(1);
+  for (int i = 0; i < n; i++) {
+    wide[i] = i == 0 ? -1 : rand() % i;
+    deep[i] = i - 1;
+  }
+  if (run("wide", wide, queries) != 0)
+    return 1;
+  return run("deep", deep, queries);
+}
@@ -11,9 +11,9 @@
 //  General support code for lexer and parser.
 //
 //  This file contains:
-//      fatal_error            print an error message and exit
 //      print_escaped_string   print a string showing escape characters
 //      print_cool_token       print a cool token and its semantic value
+//                             (to cerr unless a stream is given)
 //      dump_cool_token        dump a readable token representation
 //      strdup                 duplicate a string (missing from some libraries)
 //
@@ -33,13 +33,6 @@
 //                      01234567890123456789012345678901234567890123456789012345678901234567890123456789
 static char *padding = "                                                                                ";      // 80 spaces for padding
 
-void fatal_error(char *msg)
-{
-   cerr << msg;
-   exit(1);
-}
-
-
 void print_escaped_string(ostream& str, const char *s)
 {
   while (*s) {
@@ -123,44 +116,48 @@ char *cool_token_to_string(int tok)
   }
 }
 
-void print_cool_token(int tok)
+void print_cool_token(ostream& out, int tok)
 {
-
-  cerr << cool_token_to_string(tok);
+  out << cool_token_to_string(tok);
 
   switch (tok) {
   case (STR_CONST):
-    cerr << " = ";
-    cerr << " \"";
-    print_escaped_string(cerr, cool_yylval.symbol->get_string());
-    cerr << "\"";
+    out << " = ";
+    out << " \"";
+    print_escaped_string(out, cool_yylval.symbol->get_string());
+    out << "\"";
 #ifdef CHECK_TABLES
     stringtable.lookup_string(cool_yylval.symbol->get_string());
 #endif
     break;
   case (INT_CONST):
-    cerr << " = " << cool_yylval.symbol;
+    out << " = " << cool_yylval.symbol;
 #ifdef CHECK_TABLES
     inttable.lookup_string(cool_yylval.symbol->get_string());
 #endif
     break;
   case (BOOL_CONST):
-    cerr << (cool_yylval.boolean ? " = true" : " = false");
+    out << (cool_yylval.boolean ? " = true" : " = false");
     break;
   case (TYPEID):
   case (OBJECTID):
-    cerr << " = " << cool_yylval.symbol;
+    out << " = " << cool_yylval.symbol;
 #ifdef CHECK_TABLES
     idtable.lookup_string(cool_yylval.symbol->get_string());
 #endif
     break;
   case (ERROR): 
-    cerr << " = ";
-    print_escaped_string(cerr, cool_yylval.error_msg);
+    out << " = ";
+    print_escaped_string(out, cool_yylval.error_msg);
     break;
   }
 }
 
+void print_cool_token(int tok)
+{
+  print_cool_token(cerr, tok);
+}
+
 // dump the token in format readable by the sceond phase token lexer
 void dump_cool_token(ostream& out, int lineno, int token, YYSTYPE yylval)
 {
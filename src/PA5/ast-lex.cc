@@ -710,7 +710,7 @@ extern int verbose_flag;
 
 extern YYSTYPE ast_yylval;
 
-YYSTYPE cool_yylval;  /* needed to link ast code with utilities.cc */
+thread_local YYSTYPE cool_yylval;  /* needed to link ast code with utilities.cc */
 
 
 #line 717 "ast-lex.cc"
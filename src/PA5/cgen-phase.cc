@@ -4,15 +4,21 @@
 #include "cool-io.h"  //includes iostream
 #include "cool-tree.h"
 #include "cgen_gc.h"
+#include "ast-binary.h"
+#include "stats.h"
+#include "optimize.h"
 
 extern int optind;            // for option processing
 extern char *out_filename;    // name of output assembly
+extern int ast_verbose;       // write the AST instead (-a)
+extern int ast_binary;        // ... in binary rather than text (-b)
+extern thread_local char *cgen_skip_passes;
 extern Program ast_root;             // root of the abstract syntax tree
 FILE *ast_file = stdin;       // we read the AST from standard input
 extern int ast_yyparse(void); // entry point to the AST parser
 
 int cool_yydebug;     // not used, but needed to link with handle_flags
-char *curr_filename;
+thread_local char *curr_filename;
 
 void handle_flags(int argc, char *argv[]);
 
@@ -21,6 +27,8 @@ int main(int argc, char *argv[]) {
 
   handle_flags(argc,argv);
   firstfile_index = optind;
+  if (cgen_skip_passes && !check_pass_names(cgen_skip_passes, cerr))
+      exit(1);
 
   if (!out_filename && optind < argc) {   // no -o option
       char *dot = strrchr(argv[optind], '.');
@@ -34,17 +42,40 @@ int main(int argc, char *argv[]) {
   // Don't touch the output file until we know that earlier phases of the
   // compiler have succeeded.
   //
-  ast_yyparse();
+  begin_phase("read");
+  if (is_ast_binary(ast_file)) {
+      ast_root = read_ast_binary(ast_file, cerr);
+      if (ast_root == NULL)
+	  exit(1);
+  } else
+      ast_yyparse();
+
+  //
+  // With -a the AST read is written out instead of code, so that a
+  // typed AST can be turned into a binary one (-b) for the compiler
+  // library, which reads only those.
+  //
+  if (ast_verbose) {
+      if (ast_binary)
+	  dump_ast_binary(cout, ast_root);
+      else
+	  ast_root->dump_with_types(cout, 0);
+      exit(0);
+  }
+  begin_phase("cgen");
 
+  int errors;
   if (out_filename) {
       ofstream s(out_filename);
       if (!s) {
 	  cerr << "Cannot open output file " << out_filename << endl;
 	  exit(1);
       }
-      ast_root->cgen(s);
+      errors = ast_root->cgen(s);
   } else {
-      ast_root->cgen(cout);
+      errors = ast_root->cgen(cout);
   }
+  if (errors != 0)
+      exit(1);
 }
 